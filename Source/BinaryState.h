@@ -0,0 +1,178 @@
+/*
+  ==============================================================================
+
+    BinaryState.h
+    Created: 18 Oct 2026 6:38:02pm
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ Compact binary format for the plugin state, saved and restored without going through XML or the ValueTree.
+
+ Layout, little endian:
+ * magic number "TBST" (4 bytes)
+ * format version (2 bytes)
+ * number of parameters (2 bytes)
+ * for each parameter: hash of its ID (4 bytes), then its value in its own units (4 byte float)
+ * from version 2: path of the impulse response file, as a null terminated UTF-8 string (empty without one)
+ * from version 3: path of the audio file the grains read from ("Pantry"), the same way
+
+ Parameters are matched by the hash of their ID, so that parameters can be added, removed or reordered between
+ versions: unknown entries are skipped, and parameters missing from the state go back to their default.
+ Read-only parameters (output meters) are not saved.
+
+ States saved before this format existed start with "VC2!" instead, and are still read through the XML path of
+ TabboulehAudioProcessor::setStateInformation().
+ */
+namespace BinaryState
+{
+    /// Magic number at the start of every state ("TBST", read as a little endian int).
+    static constexpr juce::uint32 magic = 0x54534254;
+
+    /// Version written by write(). Bump it when the layout changes, keeping read() able to read older versions.
+    static constexpr int currentVersion = 3;
+
+    static constexpr size_t headerSize = 8;
+    static constexpr size_t entrySize = 8;
+
+    /// FNV-1a hash of a parameter ID, stable across platforms and JUCE versions.
+    inline juce::uint32 hashParameterID (const juce::String& parameterID)
+    {
+        juce::uint32 hash = 2166136261u;
+
+        for (auto* character = parameterID.toRawUTF8(); *character != 0; character++)
+        {
+            hash ^= (juce::uint8) *character;
+            hash *= 16777619u;
+        }
+
+        return hash;
+    }
+
+    /// Returns true if the data starts with the binary state's magic number.
+    inline bool isBinaryState (const void* data, int sizeInBytes)
+    {
+        return data != nullptr && sizeInBytes >= (int) headerSize
+            && juce::ByteOrder::littleEndianInt (data) == magic;
+    }
+
+    /**
+     Writes the value of every parameter of the processor.
+
+     @param processor processor whose parameters are saved
+     @param destData memory block replaced with the state
+     @param impulseResponsePath full path of the impulse response file "Oil" convolves with, if any
+     @param grainSourcePath full path of the audio file the grains read from, if any
+     */
+    inline void write (const juce::AudioProcessor& processor, juce::MemoryBlock& destData, const juce::String& impulseResponsePath = {},
+                       const juce::String& grainSourcePath = {})
+    {
+        auto& processorParameters = processor.getParameters();
+
+        juce::Array<juce::RangedAudioParameter*> savedParameters;
+
+        for (auto* parameter : processorParameters)
+            if (auto* rangedParameter = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+                if (rangedParameter->getCategory() != juce::AudioProcessorParameter::outputMeter)
+                    savedParameters.add (rangedParameter);
+
+        // The stream replaces whatever destData held:
+        juce::MemoryOutputStream stream (destData, false);
+        stream.writeInt ((int) magic);
+        stream.writeShort ((short) currentVersion);
+        stream.writeShort ((short) savedParameters.size());
+
+        for (auto* parameter : savedParameters)
+        {
+            stream.writeInt ((int) hashParameterID (parameter->paramID));
+            stream.writeFloat (parameter->convertFrom0to1 (parameter->getValue()));
+        }
+
+        stream.writeString (impulseResponsePath);
+        stream.writeString (grainSourcePath);
+    }
+
+    /**
+     Restores the parameters of the processor from a state written by write().
+
+     @param processor processor whose parameters are set
+     @param data the state
+     @param sizeInBytes size of the state
+     @param impulseResponsePath if not null, set to the path of the impulse response file, empty for older versions
+     @param grainSourcePath if not null, set to the path of the grain source file, empty for older versions
+     @return false if the data isn't a binary state this version can read, in which case nothing was changed
+     */
+    inline bool read (juce::AudioProcessor& processor, const void* data, int sizeInBytes, juce::String* impulseResponsePath = nullptr,
+                      juce::String* grainSourcePath = nullptr)
+    {
+        if (! isBinaryState (data, sizeInBytes))
+            return false;
+
+        auto* bytes = static_cast<const char*> (data);
+        auto version = (int) juce::ByteOrder::littleEndianShort (bytes + 4);
+        auto numEntries = (int) (juce::uint16) juce::ByteOrder::littleEndianShort (bytes + 6);
+
+        auto entriesEnd = headerSize + entrySize * (size_t) numEntries;
+
+        if (version > currentVersion || (size_t) sizeInBytes < entriesEnd)
+            return false;
+
+        // The paths follow the entries, one after the other:
+        auto readPath = [&] (size_t& position, int fromVersion)
+        {
+            if (version < fromVersion || (size_t) sizeInBytes <= position)
+                return juce::String();
+
+            auto length = strnlen (bytes + position, (size_t) sizeInBytes - position);
+            auto path = juce::String::fromUTF8 (bytes + position, (int) length);
+            position += length + 1;
+            return path;
+        };
+
+        auto pathsPosition = entriesEnd;
+        auto irPath = readPath (pathsPosition, 2);
+        auto sourcePath = readPath (pathsPosition, 3);
+
+        if (impulseResponsePath != nullptr)
+            *impulseResponsePath = irPath;
+
+        if (grainSourcePath != nullptr)
+            *grainSourcePath = sourcePath;
+
+        for (auto* parameter : processor.getParameters())
+        {
+            auto* rangedParameter = dynamic_cast<juce::RangedAudioParameter*> (parameter);
+
+            if (rangedParameter == nullptr || rangedParameter->getCategory() == juce::AudioProcessorParameter::outputMeter)
+                continue;
+
+            auto hash = hashParameterID (rangedParameter->paramID);
+            auto normalisedValue = rangedParameter->getDefaultValue();
+
+            for (int i=0; i<numEntries; i++)
+            {
+                auto* entry = bytes + headerSize + entrySize * (size_t) i;
+
+                if (juce::ByteOrder::littleEndianInt (entry) == hash)
+                {
+                    auto bits = juce::ByteOrder::littleEndianInt (entry + 4);
+                    float value;
+                    std::memcpy (&value, &bits, sizeof (value));
+
+                    normalisedValue = rangedParameter->convertTo0to1 (value);
+                    break;
+                }
+            }
+
+            if (rangedParameter->getValue() != normalisedValue)
+                rangedParameter->setValueNotifyingHost (normalisedValue);
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,723 @@
+/*
+  ==============================================================================
+
+    ConvolutionReverb.h
+    Created: 18 Oct 2026 10:31:06pm
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <complex>
+#include <memory>
+#include <vector>
+#include "FDNReverb.h"
+#include "DSPTables.h"
+
+/**
+ Convolves one channel with an impulse response of any length, without latency, through a non-uniform partitioned
+ convolution:
+ - the first headSize taps are convolved directly, sample by sample,
+ - the taps up to longStageOffset are cut into partitions of shortPartitionSize, convolved by FFT every
+   shortPartitionSize samples,
+ - the rest is cut into partitions of longPartitionSize, convolved by FFT every longPartitionSize samples.
+
+ Each FFT stage keeps the spectra of its last input segments (a frequency domain delay line) and multiplies them with
+ the spectra of its partitions. The long stage's first partition starts two of its partitions into the response, so
+ its output is only needed one whole period after its input is complete: the multiplications are spread evenly over
+ that period, a few partitions per block, and the cost of each block doesn't depend on where it falls in the period
+ or on the length of the response.
+
+ Everything is allocated by the constructor, process() never allocates.
+ */
+class PartitionedConvolver
+{
+public:
+    static constexpr int headSize = 64;
+    static constexpr int shortPartitionSize = 64;
+    static constexpr int longPartitionSize = 1024;
+    static constexpr int longStageOffset = 2 * longPartitionSize;
+
+    /**
+     @param impulseResponse the taps, at the sample rate of the audio to convolve
+     @param length number of taps
+     @param shortFFT FFT of order log2 (2 * shortPartitionSize), shared between convolvers
+     @param longFFT FFT of order log2 (2 * longPartitionSize), shared between convolvers
+     */
+    PartitionedConvolver (const float* impulseResponse, int length, const juce::dsp::FFT& shortFFT, const juce::dsp::FFT& longFFT)
+        : shortStage (shortFFT, shortPartitionSize, 1, impulseResponse, length),
+          longStage (longFFT, longPartitionSize, 2, impulseResponse, length)
+    {
+        // The head is kept reversed, so that each output is a dot product with the last headSize inputs:
+        for (int i=0; i<headSize; i++)
+            head[(size_t) (headSize - 1 - i)] = i < length ? impulseResponse[i] : 0.0f;
+
+        reset();
+    }
+
+    /// Clears the inputs and outputs in flight.
+    void reset()
+    {
+        std::fill (headDelay.begin(), headDelay.end(), 0.0f);
+        headPosition = 0;
+        shortStage.reset();
+        longStage.reset();
+    }
+
+    /**
+     Convolves a block of samples.
+
+     @param input the samples to convolve
+     @param output the convolved samples, added to what it holds
+     @param numSamples number of samples
+     */
+    void process (const float* input, float* output, int numSamples)
+    {
+        while (numSamples > 0)
+        {
+            // Up to the next short boundary, which is also where a long boundary can fall:
+            auto numToProcess = std::min (numSamples, shortPartitionSize - shortStage.position);
+
+            for (int i=0; i<numToProcess; i++)
+            {
+                // Direct convolution with the head, through a delay line written twice to always read it in one go:
+                headDelay[(size_t) headPosition] = input[i];
+                headDelay[(size_t) (headPosition + headSize)] = input[i];
+                headPosition = (headPosition + 1) % headSize;
+
+                auto* lastInputs = headDelay.data() + headPosition;
+                float sum = 0.0f;
+
+                for (int tap = 0; tap < headSize; tap++)
+                    sum += head[(size_t) tap] * lastInputs[tap];
+
+                output[i] += sum;
+            }
+
+            shortStage.process (input, output, numToProcess);
+            longStage.process (input, output, numToProcess);
+
+            input += numToProcess;
+            output += numToProcess;
+            numSamples -= numToProcess;
+        }
+    }
+
+    /// Length of the impulse response this was made with, in samples, rounded up to whole partitions.
+    int getLength() const
+    {
+        return headSize + shortStage.getLength() + longStage.getLength();
+    }
+
+private:
+    using Complex = std::complex<float>;
+
+    /// Uniformly partitioned convolution of one part of the impulse response.
+    struct Stage
+    {
+        /**
+         @param _fft FFT of twice the partition size
+         @param _partitionSize partition size
+         @param _delayInPartitions first partition, counted in partitions from the start of the response
+         @param impulseResponse the whole response
+         @param length length of the whole response
+         */
+        Stage (const juce::dsp::FFT& _fft, int _partitionSize, int _delayInPartitions, const float* impulseResponse, int length)
+            : fft (_fft), partitionSize (_partitionSize), delayInPartitions (_delayInPartitions),
+              numBins (_partitionSize + 1)
+        {
+            // The short stage ends where the long one starts, the long one at the end of the response:
+            auto start = partitionSize * delayInPartitions;
+            auto end = delayInPartitions == 1 ? std::min (length, longStageOffset) : length;
+            numPartitions = std::max (0, (end - start + partitionSize - 1) / partitionSize);
+
+            partitions.assign ((size_t) (numPartitions * numBins), Complex());
+            spectra.assign ((size_t) (numPartitions * numBins), Complex());
+            accumulator.assign ((size_t) numBins, Complex());
+            inputWindow.assign ((size_t) (2 * partitionSize), 0.0f);
+            fftBuffer.assign ((size_t) (4 * partitionSize), 0.0f);
+            output.assign ((size_t) partitionSize, 0.0f);
+
+            for (int i=0; i<numPartitions; i++)
+            {
+                std::fill (fftBuffer.begin(), fftBuffer.end(), 0.0f);
+                auto partitionStart = start + i * partitionSize;
+                auto partitionLength = std::min (partitionSize, end - partitionStart);
+                std::copy_n (impulseResponse + partitionStart, partitionLength, fftBuffer.data());
+
+                fft.performRealOnlyForwardTransform (fftBuffer.data(), true);
+                std::copy_n (reinterpret_cast<const Complex*> (fftBuffer.data()), numBins, partitions.data() + (size_t) (i * numBins));
+            }
+        }
+
+        void reset()
+        {
+            // The accumulation in progress is dropped too, so that the first period after a reset is silent:
+            std::fill (spectra.begin(), spectra.end(), Complex());
+            std::fill (accumulator.begin(), accumulator.end(), Complex());
+            std::fill (inputWindow.begin(), inputWindow.end(), 0.0f);
+            std::fill (output.begin(), output.end(), 0.0f);
+            newestSpectrum = 0;
+            position = 0;
+            numPartitionsDone = numPartitions;
+        }
+
+        /// Takes in samples, up to the end of the current partition at most, and adds what the stage outputs.
+        void process (const float* input, float* _output, int numSamples)
+        {
+            if (numPartitions == 0)
+            {
+                position = (position + numSamples) % partitionSize;
+                return;
+            }
+
+            std::copy_n (input, numSamples, inputWindow.data() + partitionSize + position);
+            juce::FloatVectorOperations::add (_output, output.data() + position, numSamples);
+            position += numSamples;
+
+            if (position == partitionSize)
+            {
+                endSegment();
+                position = 0;
+            }
+            else if (delayInPartitions > 1)
+            {
+                // Keep up with the period, so that the multiplications are spread evenly across it:
+                multiplyPartitions ((numPartitions * position + partitionSize - 1) / partitionSize);
+            }
+        }
+
+        int getLength() const
+        {
+            return numPartitions * partitionSize;
+        }
+
+        const juce::dsp::FFT& fft;
+        int partitionSize;
+        int delayInPartitions;
+        int numBins;
+        int numPartitions = 0;
+        int position = 0;                       // Samples taken in since the last segment ended
+
+    private:
+        std::vector<Complex> partitions;        // Spectra of the partitions, numBins each
+        std::vector<Complex> spectra;           // Spectra of the last numPartitions input segments, a ring
+        std::vector<Complex> accumulator;       // Sum of the products for the next output
+        std::vector<float> inputWindow;         // Last segment, then the one being taken in
+        std::vector<float> fftBuffer;
+        std::vector<float> output;              // Output for the current period
+        int newestSpectrum = 0;
+        int numPartitionsDone = 0;
+
+        /// A whole segment has been taken in: outputs what was accumulated, and starts on the new segment.
+        void endSegment()
+        {
+            // The output for the coming period, accumulated over the last one:
+            if (delayInPartitions > 1)
+                finishAccumulation();
+
+            // Spectrum of the last two segments, the first half of which is discarded after the inverse transform:
+            std::copy (inputWindow.begin(), inputWindow.end(), fftBuffer.begin());
+            std::fill (fftBuffer.begin() + 2 * partitionSize, fftBuffer.end(), 0.0f);
+            fft.performRealOnlyForwardTransform (fftBuffer.data(), true);
+
+            newestSpectrum = (newestSpectrum + 1) % numPartitions;
+            std::copy_n (reinterpret_cast<const Complex*> (fftBuffer.data()), numBins, spectra.data() + (size_t) (newestSpectrum * numBins));
+            std::copy (inputWindow.begin() + partitionSize, inputWindow.end(), inputWindow.begin());
+
+            std::fill (accumulator.begin(), accumulator.end(), Complex());
+            numPartitionsDone = 0;
+
+            // Without a spare period, the output for the coming period is needed straight away:
+            if (delayInPartitions == 1)
+                finishAccumulation();
+        }
+
+        /// Multiplies partitions with their input spectra until numPartitionsToDo of them are in the accumulator.
+        void multiplyPartitions (int numPartitionsToDo)
+        {
+            for (; numPartitionsDone < std::min (numPartitionsToDo, numPartitions); numPartitionsDone++)
+            {
+                // The i-th partition goes with the input spectrum i segments older than the newest:
+                auto spectrumIndex = (newestSpectrum - numPartitionsDone + numPartitions) % numPartitions;
+                auto* spectrum = spectra.data() + (size_t) (spectrumIndex * numBins);
+                auto* partition = partitions.data() + (size_t) (numPartitionsDone * numBins);
+
+                for (int bin = 0; bin < numBins; bin++)
+                    accumulator[(size_t) bin] += spectrum[bin] * partition[bin];
+            }
+        }
+
+        /// Finishes the accumulation and transforms it back into the output for the coming period.
+        void finishAccumulation()
+        {
+            multiplyPartitions (numPartitions);
+
+            std::fill (fftBuffer.begin(), fftBuffer.end(), 0.0f);
+            std::copy (accumulator.begin(), accumulator.end(), reinterpret_cast<Complex*> (fftBuffer.data()));
+            fft.performRealOnlyInverseTransform (fftBuffer.data());
+
+            // Overlap-save: only the second half is free of wrapped around samples:
+            std::copy_n (fftBuffer.data() + partitionSize, partitionSize, output.data());
+        }
+    };
+
+    std::array<float, headSize> head {};
+    std::array<float, 2 * headSize> headDelay {};
+    int headPosition = 0;
+    Stage shortStage;
+    Stage longStage;
+
+    JUCE_DECLARE_NON_COPYABLE (PartitionedConvolver)
+};
+
+//==============================================================================
+/**
+ Convolution reverb for the "Oil" stage, driven by the same parameters as FDNReverb, from an impulse response file.
+
+ A background thread, one per instance, does the loading: the file is read, resampled to the project's rate through a
+ windowed sinc, normalised, and cut into partitions there. The new convolvers are then handed over to the audio
+ thread through an atomic pointer, the way FileGrainSource hands over its caches, and the old ones handed back the
+ same way, to be deleted by the background thread or collectGarbage(). The audio thread never allocates, frees or
+ waits, and the message thread only opens the file to check it can be read.
+ */
+class ConvolutionReverb  : private juce::Thread
+{
+public:
+    static constexpr double maxLengthInSeconds = 10.0;
+    static constexpr int resamplingZeroCrossings = 16;      // On each side of the sinc
+
+    ConvolutionReverb()
+        : juce::Thread ("Tabbouleh impulse response"),
+          shortFFT (tables->getFFT (7)), longFFT (tables->getFFT (11)),
+          sinc (tables->getWindowedSinc (resamplingZeroCrossings))
+    {
+        static_assert ((1 << 7) == 2 * PartitionedConvolver::shortPartitionSize, "short FFT must fit two short partitions");
+        static_assert ((1 << 11) == 2 * PartitionedConvolver::longPartitionSize, "long FFT must fit two long partitions");
+    }
+
+    ~ConvolutionReverb() override
+    {
+        stopThread (4000);
+        delete incoming.exchange (nullptr);
+        delete retired.exchange (nullptr);
+    }
+
+    /**
+     Sets the rate of the project, building the convolvers again in the background if it changed. Call from
+     prepareToPlay, while the audio thread isn't running.
+
+     @param _sampleRate sample rate of the project
+     */
+    void prepare (double _sampleRate)
+    {
+        juce::File file;
+
+        {
+            const juce::ScopedLock lock (requestLock);
+
+            if (_sampleRate != sampleRate)
+                file = requestedFile;
+
+            sampleRate = _sampleRate;
+        }
+
+        collectGarbage();
+
+        if (file != juce::File())
+            request (file);
+
+        wetGain1.reset (_sampleRate, gainRampSeconds);
+        wetGain2.reset (_sampleRate, gainRampSeconds);
+        dryGain.reset (_sampleRate, gainRampSeconds);
+        dryGain.setCurrentAndTargetValue (dryGain.getTargetValue());
+        reset();
+    }
+
+    /**
+     Message thread: starts loading an impulse response file in the background, and returns straight away. The last
+     impulse response is used until the new one is ready.
+
+     @param file any audio file the AudioFormatManager can read, mono or stereo
+     @return false if the file can't be read, in which case the last impulse response is kept
+     */
+    bool loadImpulseResponse (const juce::File& file)
+    {
+        // Only the header is read here, to tell the caller straight away about a file that can't be used:
+        if (createReader (file) == nullptr)
+            return false;
+
+        request (file);
+        return true;
+    }
+
+    /// Message thread: stops using the impulse response.
+    void clearImpulseResponse()
+    {
+        request (juce::File());
+    }
+
+    /// Message thread: the file of the impulse response last asked for, or an empty File if there isn't one.
+    juce::File getImpulseResponseFile() const
+    {
+        const juce::ScopedLock lock (requestLock);
+        return requestedFile;
+    }
+
+    /**
+     Waits for the last impulse response asked for to be handed over, for offline renders that must not start without
+     it.
+
+     @return false if it timed out, or the file couldn't be read after all
+     */
+    bool waitUntilLoaded (int timeoutMilliseconds)
+    {
+        return loadFinished.wait (timeoutMilliseconds) && ! loadFailed;
+    }
+
+    /// Message thread: deletes the convolvers the audio thread is done with.
+    void collectGarbage()
+    {
+        delete retired.exchange (nullptr);
+    }
+
+    //==========================================================================
+    /// Audio thread: takes up newly loaded convolvers, if any. Returns true if there is an impulse response to use.
+    bool update()
+    {
+        // The old convolvers are only handed back once the last ones have been collected:
+        if (incoming.load() != nullptr && retired.load() == nullptr)
+        {
+            retired.store (active.release());
+            active.reset (incoming.exchange (nullptr));
+        }
+
+        return active != nullptr && ! active->isEmpty;
+    }
+
+    /// Sets the levels, with the same meaning and scaling as FDNReverb.
+    void setParameters (const FDNReverb::Parameters& parameters)
+    {
+        auto wet = wetScaleFactor * parameters.wetLevel;
+        wetGain1.setTargetValue (0.5f * wet * (1.0f + parameters.width));
+        wetGain2.setTargetValue (0.5f * wet * (1.0f - parameters.width));
+        dryGain.setTargetValue (dryScaleFactor * parameters.dryLevel);
+    }
+
+    /// Clears the convolutions in flight. The wet gains jump to their values, as the convolutions start from silence.
+    void reset()
+    {
+        if (active != nullptr)
+            for (auto& convolver : active->channels)
+                convolver->reset();
+
+        wetGain1.setCurrentAndTargetValue (wetGain1.getTargetValue());
+        wetGain2.setCurrentAndTargetValue (wetGain2.getTargetValue());
+    }
+
+    /**
+     Send path, as FDNReverb::processSend(): convolves a send signal and writes the wet signal only. Only call it when
+     update() returned true.
+
+     @param sendL left input
+     @param sendR right input
+     @param wetL left wet output, no larger than the block size given to prepare()
+     @param wetR right wet output
+     @param numSamples number of samples to process
+     */
+    void processSend (const float* sendL, const float* sendR, float* wetL, float* wetR, int numSamples)
+    {
+        auto* convolvedL = active->scratch.getWritePointer (0);
+        auto* convolvedR = active->scratch.getWritePointer (1);
+
+        for (int start = 0; start < numSamples; start += active->scratch.getNumSamples())
+        {
+            auto numToProcess = std::min (active->scratch.getNumSamples(), numSamples - start);
+            active->scratch.clear();
+
+            active->channels[0]->process (sendL + start, convolvedL, numToProcess);
+            active->channels[1]->process (sendR + start, convolvedR, numToProcess);
+
+            for (int i=0; i<numToProcess; i++)
+            {
+                auto gain1 = wetGain1.getNextValue();
+                auto gain2 = wetGain2.getNextValue();
+                wetL[start + i] = convolvedL[i] * gain1 + convolvedR[i] * gain2;
+                wetR[start + i] = convolvedR[i] * gain1 + convolvedL[i] * gain2;
+            }
+        }
+    }
+
+    /// Scales the dry signal by its gain, ramped, as FDNReverb::applyDryGain().
+    void applyDryGain (float* left, float* right, int numSamples)
+    {
+        FDNReverb::applyRampedGain (dryGain, left, right, numSamples);
+    }
+
+    /// True while the wet gain is still ramping, down to silence when "Oil" was just turned to 0.
+    bool isWetRamping() const
+    {
+        return wetGain1.isSmoothing() || wetGain2.isSmoothing();
+    }
+
+    /// Any thread: length of the impulse response in use, which the reverb rings for after its input stops.
+    double getTailLengthSeconds() const
+    {
+        return tailLengthSeconds;
+    }
+
+    //==========================================================================
+private:
+    /// One convolver per channel, and room to convolve into.
+    struct Convolvers
+    {
+        std::vector<std::unique_ptr<PartitionedConvolver>> channels;
+        juce::AudioBuffer<float> scratch { 2, 512 };
+        bool isEmpty = false;
+    };
+
+    // FDNReverb's level scaling, so that "Oil" keeps its balance whichever reverb is used:
+    static constexpr float wetScaleFactor = 3.0f;
+    static constexpr float dryScaleFactor = 2.0f;
+    static constexpr double gainRampSeconds = 0.01;
+
+    juce::SharedResourcePointer<DSPTables> tables;
+    const juce::dsp::FFT& shortFFT;                         // Shared by every instance (see DSPTables)
+    const juce::dsp::FFT& longFFT;
+    const std::vector<float>& sinc;
+
+    // Message thread and background thread, under requestLock:
+    juce::CriticalSection requestLock;
+    juce::File requestedFile;
+    bool hasRequest = false;
+    double sampleRate = 44100.0;
+    std::atomic<bool> loadFailed { false };
+    juce::WaitableEvent loadFinished { true };
+
+    // Any thread:
+    std::atomic<double> tailLengthSeconds { 0.0 };
+
+    // Background thread, the file last read, kept to build again at another rate without reading it again:
+    juce::AudioBuffer<float> impulseResponse;
+    double impulseResponseSampleRate = 44100.0;
+    juce::File impulseResponseFile;
+
+    // Audio thread, handed over through incoming and retired:
+    std::unique_ptr<Convolvers> active;
+    std::atomic<Convolvers*> incoming { nullptr };
+    std::atomic<Convolvers*> retired { nullptr };
+
+    juce::SmoothedValue<float> wetGain1;                    // Ramped as FDNReverb's
+    juce::SmoothedValue<float> wetGain2;
+    juce::SmoothedValue<float> dryGain;
+
+    //==========================================================================
+    static std::unique_ptr<juce::AudioFormatReader> createReader (const juce::File& file)
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+        std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (file));
+
+        if (reader == nullptr || reader->lengthInSamples <= 0)
+            return nullptr;
+
+        return reader;
+    }
+
+    /// Asks the background thread to load a file, or to stop convolving for an empty File.
+    void request (const juce::File& file)
+    {
+        {
+            const juce::ScopedLock lock (requestLock);
+            requestedFile = file;
+            hasRequest = true;
+            loadFinished.reset();
+        }
+
+        startThread();
+        notify();
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            juce::File fileToLoad;
+            double rate = 0.0;
+            bool shouldLoad = false;
+
+            {
+                const juce::ScopedLock lock (requestLock);
+                std::swap (shouldLoad, hasRequest);
+                fileToLoad = requestedFile;
+                rate = sampleRate;
+            }
+
+            if (shouldLoad)
+                load (fileToLoad, rate);
+
+            delete retired.exchange (nullptr);
+            wait (-1);
+        }
+    }
+
+    /// Reads a file, unless it is the one already read, builds its convolvers and hands them over.
+    void load (const juce::File& file, double rate)
+    {
+        auto loaded = true;
+
+        if (file == juce::File())
+        {
+            impulseResponse.setSize (0, 0);
+            impulseResponseFile = juce::File();
+        }
+        else if (file != impulseResponseFile || impulseResponse.getNumSamples() == 0)
+        {
+            loaded = read (file);
+        }
+
+        if (! loaded)
+        {
+            finishLoading (false);
+            return;
+        }
+
+        auto convolvers = build (rate);
+
+        // A newer request cancels this one, and is loaded next:
+        if (hasNewRequest() || threadShouldExit())
+            return;
+
+        tailLengthSeconds = impulseResponse.getNumSamples() / impulseResponseSampleRate;
+        handOver (std::move (convolvers));
+        finishLoading (true);
+    }
+
+    /// Reads up to maxLengthInSeconds of a file, keeping the last one read if it can't be.
+    bool read (const juce::File& file)
+    {
+        auto reader = createReader (file);
+
+        if (reader == nullptr)
+            return false;
+
+        auto length = (int) std::min (reader->lengthInSamples, (juce::int64) (maxLengthInSeconds * reader->sampleRate));
+        impulseResponse.setSize (std::min (2, (int) reader->numChannels), length);
+        reader->read (&impulseResponse, 0, length, 0, true, true);
+        impulseResponseSampleRate = reader->sampleRate;
+        impulseResponseFile = file;
+        return true;
+    }
+
+    /// Tells the waiting threads the load is over, unless a newer request came in, which is then the one to wait for.
+    void finishLoading (bool succeeded)
+    {
+        const juce::ScopedLock lock (requestLock);
+
+        if (hasRequest)
+            return;
+
+        loadFailed = ! succeeded;
+        loadFinished.signal();
+    }
+
+    bool hasNewRequest() const
+    {
+        const juce::ScopedLock lock (requestLock);
+        return hasRequest;
+    }
+
+    /// Passes new convolvers, or empty ones to stop convolving, to the audio thread.
+    void handOver (std::unique_ptr<Convolvers> convolvers)
+    {
+        if (convolvers == nullptr)
+        {
+            convolvers.reset (new Convolvers());
+            convolvers->isEmpty = true;
+        }
+
+        collectGarbage();
+        delete incoming.exchange (convolvers.release());
+    }
+
+    /// Resamples and normalises the impulse response, and cuts it into partitions. Returns nullptr without one.
+    std::unique_ptr<Convolvers> build (double rate) const
+    {
+        if (impulseResponse.getNumSamples() == 0)
+            return nullptr;
+
+        auto ratio = impulseResponseSampleRate / rate;
+        auto length = std::max (1, (int) (impulseResponse.getNumSamples() / ratio));
+        juce::AudioBuffer<float> resampled (2, length);
+
+        for (int channel = 0; channel < 2; channel++)
+            resample (impulseResponse.getReadPointer (std::min (channel, impulseResponse.getNumChannels() - 1)),
+                      impulseResponse.getNumSamples(), ratio, resampled.getWritePointer (channel), length);
+
+        // Unit energy per channel, so that the wet level doesn't depend on the file:
+        auto energy = 0.0f;
+
+        for (int channel = 0; channel < 2; channel++)
+            for (int i=0; i<length; i++)
+                energy += resampled.getSample (channel, i) * resampled.getSample (channel, i);
+
+        if (energy > 0.0f)
+            resampled.applyGain (std::sqrt (2.0f / energy));
+
+        auto convolvers = std::make_unique<Convolvers>();
+
+        for (int channel = 0; channel < 2; channel++)
+            convolvers->channels.push_back (std::make_unique<PartitionedConvolver> (resampled.getReadPointer (channel), length, shortFFT, longFFT));
+
+        return convolvers;
+    }
+
+    /**
+     Band-limited resampling through the windowed sinc. Going down in rate, the sinc is stretched so that its cutoff
+     falls at the new Nyquist frequency: what the new rate can't hold is filtered out rather than folded back.
+
+     @param source samples at the file's rate
+     @param sourceLength number of source samples
+     @param ratio the file's rate over the project's rate
+     @param destination receives the samples at the project's rate
+     @param length number of samples to write
+     */
+    void resample (const float* source, int sourceLength, double ratio, float* destination, int length) const
+    {
+        if (ratio == 1.0)
+        {
+            std::copy_n (source, std::min (length, sourceLength), destination);
+            std::fill (destination + std::min (length, sourceLength), destination + length, 0.0f);
+            return;
+        }
+
+        auto cutoff = std::min (1.0, 1.0 / ratio);
+        auto radius = resamplingZeroCrossings / cutoff;                // In source samples
+        auto stepsPerSample = cutoff * DSPTables::sincResolution;      // Table steps per source sample
+        auto gain = (float) cutoff;
+
+        for (int i=0; i<length; i++)
+        {
+            auto position = i * ratio;
+            auto first = std::max (0, (int) std::ceil (position - radius));
+            auto last = std::min (sourceLength - 1, (int) std::floor (position + radius));
+            float sum = 0.0f;
+
+            for (int j = first; j <= last; j++)
+            {
+                auto step = std::abs (position - j) * stepsPerSample;
+                auto index = (int) step;
+                auto fraction = (float) (step - index);
+                sum += source[j] * (sinc[(size_t) index] + fraction * (sinc[(size_t) index + 1] - sinc[(size_t) index]));
+            }
+
+            destination[i] = gain * sum;
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (ConvolutionReverb)
+};
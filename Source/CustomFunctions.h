@@ -12,9 +12,10 @@
 
 #include <math.h>
 #include "Oscillator.h"
+#include "FDNReverb.h"
 
 /// Sets mapped reverb parameters according to Two custom parameters.
-void setReverbParams(juce::Reverb::Parameters& reverbParams, float oilLevel, float spiceLevel)
+inline void setReverbParams(FDNReverb::Parameters& reverbParams, float oilLevel, float spiceLevel)
 {
     //Calculate Params
     float wetLevel = 0.8f * oilLevel;
@@ -29,19 +30,19 @@ void setReverbParams(juce::Reverb::Parameters& reverbParams, float oilLevel, flo
 }
 
 ///Converts Midi note (0-127) to float frequency
-float midiToFrequency (int midiNote, float freqA = 440.0f)
+inline float midiToFrequency (int midiNote, float freqA = 440.0f)
 {
     return freqA * pow (2.0, (midiNote - 69) / 12.0);
 }
 
 ///Converts frequency into midi note
-float frequencyToMidi (float frequency, float freqA = 440.0f)
+inline float frequencyToMidi (float frequency, float freqA = 440.0f)
 {
     return 12 * log2 (frequency / freqA) + 69;
 }
 
 /// Returns the tuned frequency according to precision and tuning.
-float adjustedFrequency (float frequency, float precision, float freqA = 440.0f)
+inline float adjustedFrequency (float frequency, float precision, float freqA = 440.0f)
 {
     float relativeMidiNote = frequencyToMidi (frequency, freqA);
     float nearestMidiNote = round (relativeMidiNote);
@@ -50,12 +51,66 @@ float adjustedFrequency (float frequency, float precision, float freqA = 440.0f)
     return midiToFrequency (adjustedMidi, freqA);
 }
 
+/**
+ Band the pitch analysis listens to, applied to the spectrum rather than to the captured samples.
+ 
+ Bins are weighted as if by a second order high pass at lowFrequency and a second order low pass at highFrequency,
+ and only bins from an octave below the band to an octave above it are searched, everything else being masked off.
+ */
+struct AnalysisBand
+{
+    float lowFrequency = 60.0f;
+    float highFrequency = 5000.0f;
+    
+    /// Returns the squared magnitude response of the band at a frequency, in [0, 1].
+    float getPowerWeight (float frequency) const
+    {
+        float lowRatio = lowFrequency / frequency;
+        float highRatio = frequency / highFrequency;
+        lowRatio *= lowRatio;
+        highRatio *= highRatio;
+        
+        return 1.0f / ((1.0f + lowRatio * lowRatio) * (1.0f + highRatio * highRatio));
+    }
+    
+    /**
+     Finds the bin with the highest weighted magnitude within the band.
+     
+     @param magnitudes magnitudes of a transform, as written by performFrequencyOnlyForwardTransform
+     @param fftSize size of the transform
+     @param sampleRate sample rate of the transformed audio
+     @return index of the bin, 0 if every bin of the band is silent
+     */
+    int findPeakBin (const float* magnitudes, int fftSize, double sampleRate) const
+    {
+        auto binWidth = (float) (sampleRate / fftSize);
+        int firstBin = std::max (1, (int) std::ceil (0.5f * lowFrequency / binWidth));
+        int lastBin = std::min (fftSize / 2, (int) (2.0f * highFrequency / binWidth));
+        
+        int index = 0;
+        float maxPower = 0.0f;
+        
+        for (int i=firstBin; i<=lastBin; i++)
+        {
+            float power = magnitudes[i] * magnitudes[i] * getPowerWeight (i * binWidth);
+            
+            if (power > maxPower)
+            {
+                index = i;
+                maxPower = power;
+            }
+        }
+        
+        return index;
+    }
+};
+
 
 /**
  Processes three oscillators and returns the mixed output of all three according to the parameter.
  @param OscillatorSelect float in range [1-3]
  */
-float processOscillators(float oscillatorSelect, SineOsc& _sineOsc, TriOsc& _triOsc, AntiAliasSawToothOsc& _sawOsc)
+inline float processOscillators(float oscillatorSelect, SineOsc& _sineOsc, TriOsc& _triOsc, AntiAliasSawToothOsc& _sawOsc)
 {
     float sinSample = _sineOsc.process();
     float triSample = _triOsc.process();
@@ -68,4 +123,48 @@ float processOscillators(float oscillatorSelect, SineOsc& _sineOsc, TriOsc& _tri
     return 0.33f * ((sinSample * sinVolume) + (triSample * triVolume) + (sawSample * sawVolume));
 }
 
+/// Oscillators heard at a given oscillator select value: the triangle is silent at both ends, the saw at 1.
+enum class OscillatorSet
+{
+    sineOnly = 0,
+    sineAndSaw,
+    all,
+    numSets
+};
+
+/// Returns the oscillators heard at the oscillator select value (in range [1-3]).
+inline OscillatorSet getOscillatorSet (float oscillatorSelect)
+{
+    if (oscillatorSelect <= 1.0f)
+        return OscillatorSet::sineOnly;
+    
+    if (oscillatorSelect >= 3.0f)
+        return OscillatorSet::sineAndSaw;
+    
+    return OscillatorSet::all;
+}
+
+/**
+ Same as processOscillators, for a set of oscillators known at compile time: the silent ones aren't processed at all.
+ @param OscillatorSelect float in range [1-3], heard through the given set of oscillators
+ */
+template <OscillatorSet oscillators>
+inline float processOscillators (float oscillatorSelect, SineOsc& _sineOsc, TriOsc& _triOsc, AntiAliasSawToothOsc& _sawOsc)
+{
+    if constexpr (oscillators == OscillatorSet::all)
+    {
+        return processOscillators (oscillatorSelect, _sineOsc, _triOsc, _sawOsc);
+    }
+    else
+    {
+        float sinVolume = -0.2f * oscillatorSelect + 1.5f;
+        float output = _sineOsc.process() * sinVolume;
+        
+        if constexpr (oscillators == OscillatorSet::sineAndSaw)
+            output += _sawOsc.process() * 0.5f * (0.5f * oscillatorSelect - 0.5f);
+        
+        return 0.33f * output;
+    }
+}
+
 
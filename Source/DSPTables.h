@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    DSPTables.h
+    Created: 18 Oct 2026 3:27:41am
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <map>
+#include <memory>
+#include <vector>
+
+/**
+ Immutable DSP tables shared by every voice of every instance in the process: FFTs and their twiddle factors, windows,
+ and windowed sincs. A table is worked out the first time something asks for it, and the same one is handed to
+ everyone asking for the same parameters afterwards, so that a session of many instances holds a single copy of each.
+
+ Hold it through a juce::SharedResourcePointer, which counts the instances using it: the tables go away with the
+ last one. Ask for the tables when constructing or preparing, as the lookups lock, then use them from any thread.
+ They are never changed once made, and a juce::dsp::FFT keeps no state between transforms, so any number of threads
+ can use the same table at once.
+ */
+class DSPTables
+{
+public:
+    static constexpr int sincResolution = 512;              // Steps per zero crossing of the windowed sincs
+
+    /**
+     Returns the FFT of the given order, made on the first call for that order.
+
+     @param order log2 of the size of the FFT
+     */
+    const juce::dsp::FFT& getFFT (int order)
+    {
+        const juce::ScopedLock lock (tablesLock);
+        auto& fft = ffts[order];
+
+        if (fft == nullptr)
+            fft = std::make_unique<juce::dsp::FFT> (order);
+
+        return *fft;
+    }
+
+    /**
+     Returns a periodic hann window, whose overlapping copies add up to a constant, made on the first call for that size.
+
+     @param size length of the window, in samples
+     */
+    const std::vector<float>& getHannWindow (int size)
+    {
+        const juce::ScopedLock lock (tablesLock);
+        auto& window = hannWindows[size];
+
+        if (window == nullptr)
+        {
+            window = std::make_unique<std::vector<float>> ((size_t) size);
+
+            for (int i=0; i<size; i++)
+                (*window)[(size_t) i] = 0.5f - 0.5f * std::cos (juce::MathConstants<float>::twoPi * i / size);
+        }
+
+        return *window;
+    }
+
+    /**
+     Returns the right half of a Blackman windowed sinc, in sincResolution steps per zero crossing, for band-limited
+     resampling, made on the first call for that length. It ends with two zeros, to interpolate up to its last step.
+
+     @param numZeroCrossings number of zero crossings on each side
+     */
+    const std::vector<float>& getWindowedSinc (int numZeroCrossings)
+    {
+        const juce::ScopedLock lock (tablesLock);
+        auto& sinc = windowedSincs[numZeroCrossings];
+
+        if (sinc == nullptr)
+        {
+            auto size = numZeroCrossings * sincResolution;
+            sinc = std::make_unique<std::vector<float>> ((size_t) size + 2, 0.0f);
+
+            for (int i=0; i<size; i++)
+            {
+                auto x = (double) i / sincResolution;
+                auto phase = juce::MathConstants<double>::pi * x / numZeroCrossings;
+                auto window = 0.42 + 0.5 * std::cos (phase) + 0.08 * std::cos (2.0 * phase);
+                auto value = i == 0 ? 1.0 : std::sin (juce::MathConstants<double>::pi * x) / (juce::MathConstants<double>::pi * x);
+                (*sinc)[(size_t) i] = (float) (value * window);
+            }
+        }
+
+        return *sinc;
+    }
+
+    /// Number of tables made so far, for the benchmarks.
+    int getNumTables() const
+    {
+        const juce::ScopedLock lock (tablesLock);
+        return (int) (ffts.size() + hannWindows.size() + windowedSincs.size());
+    }
+
+    //==========================================================================
+private:
+    juce::CriticalSection tablesLock;
+
+    // Tables are never moved nor removed once made, so references to them stay valid:
+    std::map<int, std::unique_ptr<juce::dsp::FFT>> ffts;
+    std::map<int, std::unique_ptr<std::vector<float>>> hannWindows;
+    std::map<int, std::unique_ptr<std::vector<float>>> windowedSincs;
+};
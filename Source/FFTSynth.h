@@ -11,6 +11,10 @@
 #pragma once
 #include "CustomFunctions.h"
 #include "Oscillator.h"
+#include "PerformanceCounters.h"
+#include "TraceRecorder.h"
+#include "MyFilters.h"
+#include "DSPTables.h"
 
 /**
  This class creates an instance of a synth which listens to an input and follows it.
@@ -21,9 +25,15 @@
  
  Variable names and types are identical to those used in that tutorial, it is the member functions that change to adapt to this use.
  
- The FFT has an order of 16 to ensure that any incoming data from the grains will fit.
+ The pitch is only looked for below 5 kHz, so the grains are listenned to at analysisRate or just below it: the windowed
+ samples are decimated by an integer factor (see Decimator) before they are stored. The FFT then has the same size and
+ cost, and gives the same resolution, whatever the sample rate of the project.
+ 
+ The state used at every sample comes first, and the class is aligned on cache lines, so that the voices kept side by
+ side in a vector share a few cache lines and pages. The 192 KB of analysis buffers, only touched once per grain, live
+ on the heap (see AnalysisBuffers).
  */
-class FFTSynth
+class alignas (64) FFTSynth
 {
 public:
     
@@ -34,8 +44,9 @@ public:
      
      It starts by clearing the input - output float buffers used in the fourier transform, sets the sample rate,
      sets the frequency of 25Hz to the Hann Oscillator (for a half period of 0.02 seconds),
-     sets the value of the float to be multiplied by the returned index of the highest,
-     sets the filter coefficients to remove lows and highs from incoming audio.
+     and prepares the decimator for the analysis rate.
+     Lows and highs are left out of the analysis in the frequency domain (see setAnalysisBand), 60 Hz to 5 kHz until
+     the processor sets the band from "Tomato Roots" and "Tomato Leaves".
      
      @param _sampleRate Sample rate of project.
      @param _envelopeShape Float between [0-1], 0 denoting short attack and long release, and 1 denoting long attack short release.
@@ -43,10 +54,11 @@ public:
      @param _precision float between [0-1] determining the degree of tuning to 12 tone temperement
      @param _freqA Frequency of A3 in tuning.
      */
-    FFTSynth(int _sampleRate, float _envelopeShape, float _grainLengthInSeconds, float _precision, float _freqA) : forwardFFT (fftOrder)
+    FFTSynth(int _sampleRate, float _envelopeShape, float _grainLengthInSeconds, float _precision, float _freqA)
+        : forwardFFT (&tables->getFFT (fftOrder)), reducedFFT (&tables->getFFT (reducedFftOrder)), analysis (std::make_unique<AnalysisBuffers>())
     {
-        std::fill (fftData.begin(), fftData.end(), 0.0f);
-        std::fill (fifo.begin(), fifo.end(), 0.0f);
+        std::fill (analysis->fftData.begin(), analysis->fftData.end(), 0.0f);
+        std::fill (analysis->fifo.begin(), analysis->fifo.end(), 0.0f);
         
         sampleRate = _sampleRate;
         triOsc.setSampleRate (sampleRate);
@@ -56,14 +68,11 @@ public:
         
         sinOscForHann.setFrequency (25.0f);
         
-        indexMultiplierForFrequencyAquisition = sampleRate / float (fftSize);
+        decimator.prepare (sampleRate, analysisRate);
         
         setEnvelopeParams (_envelopeShape, _grainLengthInSeconds);
         setRealEnvelopeParams();
         
-        lpFilter.setCoefficients (juce::IIRCoefficients::makeLowPass (sampleRate, 5000.0f));
-        hpFilter.setCoefficients (juce::IIRCoefficients::makeHighPass (sampleRate, 60.0f));
-        
         setPrecision (_precision, _freqA);
     }
     
@@ -87,21 +96,39 @@ public:
      
      
      After that, it checks whether is should be listenning for samples.
-     If it should, it sums the channels to Mono,  applies a hann window to them and stores them in the fifo sample by sample.
+     If it should, it sums the channels to Mono,  applies a hann window to them and stores them, decimated, in the fifo.
      While doing that, it keeps track of the maximum amplitude used in the signal to determine whether or not to process the FFT.
      It stops listenning once the hann window has ended.
      
      */
     void writeInSamples (float leftSample, float rightSample, bool newGrainStarted, float newThreshold, float _chanceToSkip, float _stereoRandomness)
     {
+        // Without analysis, only forget about the grain being listenned to so that it is never analysed half captured.
+        if (! analysisEnabled)
+        {
+            if (newGrainStarted == true)
+            {
+                listenning = false;
+                grainMaxAbsSample = 0.0f;
+                
+                if (counters != nullptr)
+                    counters->addSkippedAnalysis();
+            }
+            return;
+        }
+        
         // When a new grain starts: refresh buffers, enable listenning, and depending on the whether the last grain was loud enough, analyse it.
         if (newGrainStarted == true)
         {
-            // Refreshing buffers
-            std::fill (fftData.begin(), fftData.end(), 0.0f);
-            std::copy (fifo.begin(), fifo.end(), fftData.begin());
-            std::fill (fifo.begin(), fifo.end(), 0.0f);
+            // Let the decimator ring out into the fifo, then refreshing buffers
+            if (listenning)
+                flushDecimator();
+            
+            std::fill (analysis->fftData.begin(), analysis->fftData.end(), 0.0f);
+            std::copy (analysis->fifo.begin(), analysis->fifo.end(), analysis->fftData.begin());
+            std::fill (analysis->fifo.begin(), analysis->fifo.end(), 0.0f);
             fifoIndex = 0;
+            decimator.reset();
             
             // Enable listenning
             listenning = true;
@@ -113,28 +140,38 @@ public:
             if (grainMaxAbsSample > grainMaxAbsSampleThreshold && random.nextFloat() > _chanceToSkip)
             {
                 synthVolume = grainMaxAbsSample;
+                auto fftStartTicks = juce::Time::getHighResolutionTicks();
                 processFFT();
+                
+                if (counters != nullptr)
+                    counters->addAnalysis (juce::Time::getHighResolutionTicks() - fftStartTicks);
+                
+                if (trace != nullptr && trace->isRecording())
+                    trace->addSpan (TraceEvent::analysis, fftStartTicks, traceVoice);
+                
                 stereoVolumeLeft = 0.5f + ((random.nextFloat() - 0.5f) * _stereoRandomness);
                 stereoVolumeRight = 1.0f - stereoVolumeLeft;
             }
+            else if (counters != nullptr)
+            {
+                counters->addSkippedAnalysis();
+            }
             // Reset the last max abs sample
             grainMaxAbsSample = 0.0f;
-            
-            // Reset the filters
-            lpFilter.reset();
-            hpFilter.reset();
         }
         
         // While listenning (1 hann window length): store windowed incoming audio in fifo, keep track of max sample. stop listenning at the end of the hann window.
         if (listenning == true)
         {
-            // Window and filter audio
+            // Window audio, its band is only limited once transformed
             float hannToBeSquared = sinOscForHann.process();
-            float monoSampleRaw = (leftSample + rightSample) * 0.5f * hannToBeSquared * hannToBeSquared;
-            float monoSample = lpFilter.processSingleSampleRaw(hpFilter.processSingleSampleRaw(monoSampleRaw));
+            float monoSample = (leftSample + rightSample) * 0.5f * hannToBeSquared * hannToBeSquared;
+            
+            // Store in fifo, at the analysis rate
+            float decimatedSample;
             
-            // Store in fifo
-            fifo[(size_t) fifoIndex++] = monoSample;
+            if (decimator.process (monoSample, decimatedSample) && fifoIndex < fftSize)
+                analysis->fifo[(size_t) fifoIndex++] = decimatedSample;
             
             // Keep track of max sample
             float AbsSample = std::abs (monoSample);
@@ -144,7 +181,10 @@ public:
             
             // Check when to stop listenning
             if (sinOscForHann.getPhase() > 0.5)
+            {
                 listenning = false;
+                flushDecimator();
+            }
         }
         
         setGrainMaxAbsSampleThreshold (newThreshold);
@@ -152,6 +192,43 @@ public:
     
     
     
+    /**
+     Method to be run at each sample instead of writeInSamples, when the grains play from a frozen buffer whose analysis
+     is already known (see FreezeAnalysis). It behaves the same, but looks the analysis up instead of listenning.
+     
+     @param frequency peak frequency found at the start of the current grain
+     @param peak highest absolute sample found at the start of the current grain
+     @param newGrainStarted boolean to be taken from the grain class method .newGrainStarted.
+     @param newThreshold threshold a sample must surpass to trigger the synth
+     @param _chanceToSkip Probability of skipping a grain
+     @param _stereoRandomness width of stereo field
+     */
+    void writeInAnalysedGrain (float frequency, float peak, bool newGrainStarted, float newThreshold, float _chanceToSkip, float _stereoRandomness)
+    {
+        if (newGrainStarted == true)
+        {
+            listenning = false;
+            
+            // As when listenning, the last grain plays if it was loud enough:
+            if (grainMaxAbsSample > grainMaxAbsSampleThreshold && analysedFrequency > 0.0f && random.nextFloat() > _chanceToSkip)
+            {
+                synthVolume = grainMaxAbsSample;
+                startNote (analysedFrequency);
+                
+                if (counters != nullptr)
+                    counters->addAnalysisLookup();
+                stereoVolumeLeft = 0.5f + ((random.nextFloat() - 0.5f) * _stereoRandomness);
+                stereoVolumeRight = 1.0f - stereoVolumeLeft;
+            }
+            
+            // Keep the new grain's analysis for when it ends:
+            grainMaxAbsSample = peak;
+            analysedFrequency = frequency;
+        }
+        
+        setGrainMaxAbsSampleThreshold (newThreshold);
+    }
+    
     /**
      Stores temporary values for envelope shape and grain length, which will be used only when needed (Hence the private method setRealEnvelopeParams)
      
@@ -169,7 +246,10 @@ public:
      Method to also be called every sample.
      Takes an Oscillator select parameter:
      @param _oscillatorSelect float bewteen [1-3], sliding between a sine, triangle and sawtooth respectively.
+     
+     The oscillators to process can be narrowed down at compile time to those heard at _oscillatorSelect (see getOscillatorSet).
      */
+    template <OscillatorSet oscillators = OscillatorSet::all>
     float processSynth(float _oscillatorSelect)
     {
         if (synthIsPlaying)
@@ -178,21 +258,24 @@ public:
             
             if (sampleCount < grainLengthInSamples)
             {
-                float synthSample = processOscillators (_oscillatorSelect, sinOsc, triOsc, sawOsc);
+                float synthSample = processOscillators<oscillators> (_oscillatorSelect, sinOsc, triOsc, sawOsc);
                 
                 if (sampleCount < envelopeShapeInSamples - 1)
                 {
-                    return synthSample * tanhf (synthVolume * 2.0f * sampleCount / float (grainLengthInSamples));
+                    envelopeLevel = tanhf (synthVolume * 2.0f * sampleCount / float (grainLengthInSamples));
                 }
                 
                 else
                 {
-                    return synthSample * tanhf (synthVolume * (sampleCount * descentSlope + descentIntercept));
+                    envelopeLevel = tanhf (synthVolume * (sampleCount * descentSlope + descentIntercept));
                 }
+                
+                return synthSample * envelopeLevel;
             }
             else
             {
                 synthIsPlaying = false;
+                envelopeLevel = 0.0f;
                 return 0.0f;
             }
         }
@@ -223,48 +306,187 @@ public:
         freqA = _freqA;
     }
     
+    /// Returns true while a note is playing.
+    bool isPlaying() const
+    {
+        return synthIsPlaying;
+    }
+    
+    /// Returns true between the start of a note and the next call to processSynth.
+    bool isNoteStarting() const
+    {
+        return synthIsPlaying && sampleCount == -1;
+    }
+    
+    /// Returns the frequency found in the last analysed grain, before tuning.
+    float getDetectedFrequency() const
+    {
+        return synthFrequency;
+    }
+    
+    /// Returns the frequency of the last note, once tuned.
+    float getNoteFrequency() const
+    {
+        return noteFrequency;
+    }
+    
+    float getSynthVolume() const
+    {
+        return synthVolume;
+    }
+    
+    /// Returns the envelope of the note at the last processed sample, 0 when not playing.
+    float getEnvelopeLevel() const
+    {
+        return envelopeLevel;
+    }
+    
+    /**
+     Turns the listenning and analysis of grains on or off. A note already playing carries on until its end.
+     Used by the QualityGovernor to save CPU time.
+     */
+    void setAnalysisEnabled (bool shouldAnalyse)
+    {
+        analysisEnabled = shouldAnalyse;
+    }
+    
+    /**
+     Ends the note playing and forgets the grain being listenned to, for when the synth can't be heard and stops being
+     processed. Once processed again, it listens from the start of the next grain, and its first note fades in as usual.
+     */
+    void stop()
+    {
+        synthIsPlaying = false;
+        envelopeLevel = 0.0f;
+        listenning = false;
+        grainMaxAbsSample = 0.0f;
+        decimator.reset();
+    }
+    
+    /**
+     Uses the smaller FFT for the analysis, trading frequency resolution for CPU time.
+     The hann window only lasts 20 ms, 320 samples at the analysis rate, so the smaller FFT still holds all of it.
+     */
+    void setSmallerFFT (bool shouldUseSmallerFFT)
+    {
+        useSmallerFFT = shouldUseSmallerFFT;
+    }
+    
+    
+    /// Counts the analyses run and skipped into the given counters, or nowhere if nullptr.
+    void setPerformanceCounters (PerformanceCounters* _counters)
+    {
+        counters = _counters;
+    }
     
-    static constexpr auto fftOrder = 16;                // Order 16 --> 2 ^ 16 = 65532 samples covers grains of 500 ms at 92 kHz
+    /**
+     Records the analyses run into the given trace while it records, or nowhere if nullptr.
+     
+     @param _voice index of the synth, to tell it apart in the trace
+     */
+    void setTraceRecorder (TraceRecorder* _trace, int _voice)
+    {
+        trace = _trace;
+        traceVoice = _voice;
+    }
+    
+    /**
+     Sets the band the analysis looks for the pitch in. Outside of it the spectrum is weighted down, then ignored
+     (see AnalysisBand).
+     
+     @param lowFrequency lower edge of the band, in Hz
+     @param highFrequency upper edge of the band, in Hz
+     */
+    void setAnalysisBand (float lowFrequency, float highFrequency)
+    {
+        analysisBand.lowFrequency = lowFrequency;
+        analysisBand.highFrequency = highFrequency;
+    }
+    
+    /// Seeds the random choices of which notes are skipped and where they sit in the stereo field.
+    void setRandomSeed (juce::int64 seed)
+    {
+        random.setSeed (seed);
+    }
+    
+    
+    /**
+     Transforms a grain listenned to at the analysis rate, and returns the frequency of its highest bin within the band.
+     FreezeAnalysis goes through it too, so that the frequencies it looks up are those the voices would find.
+     
+     @param fft transform to use
+     @param fftData the decimated grain padded with zeros, twice the size of the transform, transformed in place
+     @param band band the pitch is looked for in
+     @param decimatedRate rate the grain was decimated to
+     @return frequency of the peak in Hz, 0 if the band is silent
+     */
+    static float findPeakFrequency (const juce::dsp::FFT& fft, float* fftData, const AnalysisBand& band, double decimatedRate)
+    {
+        int size = fft.getSize();
+        fft.performFrequencyOnlyForwardTransform (fftData);
+        
+        return band.findPeakBin (fftData, size, decimatedRate) * float (decimatedRate / size);
+    }
+    
+    
+    static constexpr double analysisRate = 16000.0;     // Highest rate grains are listenned to at, 14.7 kHz at 44.1 kHz
+    static constexpr auto fftOrder = 14;                // Order 14 --> 16384 samples, bins under 1 Hz apart at the analysis rate
     static constexpr auto fftSize = 1 << fftOrder;
+    static constexpr auto reducedFftOrder = 11;         // Order 11 --> 2048 samples, enough for the 20 ms hann window
+    static constexpr auto reducedFftSize = 1 << reducedFftOrder;
     
 private:
     
-    //FFT PARAMETERS
-    juce::dsp::FFT forwardFFT;                          // fft instance
-    std::array<float, fftSize> fifo;                    // input array
-    std::array<float, fftSize * 2> fftData;             // transform data
+    /// Cold: the grain listenned to and its transform, only read in full when a grain ends.
+    struct AnalysisBuffers
+    {
+        std::array<float, fftSize> fifo;                // input array
+        std::array<float, fftSize * 2> fftData;         // transform data
+    };
+    
+    // HOT, used at every sample:
+    int sampleCount = 0;
+    bool synthIsPlaying = false;
+    bool listenning = false;                            // status of hann window.
+    bool analysisEnabled = true;
+    bool useSmallerFFT = false;
+    float envelopeLevel = 0.0f;                         // Envelope at the last processed sample
+    float synthVolume = 1.0f;
+    int envelopeShapeInSamples;
+    int grainLengthInSamples;
+    float descentSlope;
+    float descentIntercept;
+    float stereoVolumeLeft = 0.5f;
+    float stereoVolumeRight = 0.5f;
     int fifoIndex = 0;                                  // temporary index keeps track of filled in samples
     float grainMaxAbsSample = 0.0f;
     float grainMaxAbsSampleThreshold = 0.01f;
-    bool listenning = false;                            // status of hann window.
-    int sampleRate;                                     // Sample rate of project
-    juce::IIRFilter lpFilter;                           // Low Pass Filter
-    juce::IIRFilter hpFilter;                           // High Pass Filter
-    SineOsc sinOscForHann;                              // Oscillator for Hann window
-
-    
-    // SYNTH PARAMETERS
     TriOsc triOsc;                                      // Synth oscillator
     SineOsc sinOsc;                                     // Synth oscillator
     AntiAliasSawToothOsc sawOsc;                        // Synth oscillator
+    SineOsc sinOscForHann;                              // Oscillator for Hann window
+    Decimator decimator;                                // Brings the windowed samples down to the analysis rate
     
+    // COLD, used once per grain or when parameters change:
+    juce::SharedResourcePointer<DSPTables> tables;
+    const juce::dsp::FFT* forwardFFT;                   // fft instance, shared by every voice (see DSPTables)
+    const juce::dsp::FFT* reducedFFT;                   // smaller fft instance, for when CPU time runs short
+    std::unique_ptr<AnalysisBuffers> analysis;
+    AnalysisBand analysisBand;                          // Band the pitch is looked for in
+    PerformanceCounters* counters = nullptr;
+    TraceRecorder* trace = nullptr;
+    int traceVoice = 0;
+    int sampleRate;                                     // Sample rate of project
     float synthFrequency = 1.0f;
-    int sampleCount = 0;
-    bool synthIsPlaying = false;                        
-    float synthVolume = 1.0f;
-    float stereoVolumeLeft = 0.5f;
-    float stereoVolumeRight = 0.5f;
+    float analysedFrequency = 0.0f;                     // Frequency looked up for the current grain, when frozen
+    float noteFrequency = 0.0f;                         // Tuned frequency of the last note
     float freqA = 440.0f;
     float precision = 0.2f;
-    juce::Random random;
-    float indexMultiplierForFrequencyAquisition;
     float envelopeShape;
-    int envelopeShapeInSamples;
-    int grainLengthInSamples;
     float envelopeShapeTemp;
     int grainLengthInSamplesTemp;
-    float descentSlope;
-    float descentIntercept;
+    juce::Random random;
+    
     /**
      sets the temporary values of envelope shape and grain size in stone when called by the private method processFFT()
      
@@ -283,7 +505,7 @@ private:
     /**
      Private method runs the FFT on the last grain and applies it accordingly:
      
-     From the FFT, grab the peak frequency simply by finding the index of the highest sample in the first half of the transform,
+     From the FFT, grab the peak frequency simply by finding the index of the highest bin within the analysis band,
      and multiplying it by the ratio sampleRate / FFT size.
      
      Set the calculated frequency to the synth, recalibrate envelope parameters, reset the sample count to 0.
@@ -291,23 +513,33 @@ private:
      */
     void processFFT()
     {
-        forwardFFT.performFrequencyOnlyForwardTransform (fftData.data());
+        auto& fft = useSmallerFFT ? *reducedFFT : *forwardFFT;
         
-        // Get Main Frequency
-        int index = 0;
-        float maxAmplitude = 0.0f;
-        for (int i=0; i<fftSize; i++)
-        {
-            float binAbsAmplitude = std::abs (fftData[i]);
-            if (binAbsAmplitude > maxAmplitude)
-            {
-                index = i;
-                maxAmplitude = binAbsAmplitude;
-            }
-        }
+        startNote (findPeakFrequency (fft, analysis->fftData.data(), analysisBand, decimator.getOutputRate()));
+    }
+    
+    /// Feeds silence to the decimator until the end of the window has come out of it, into the fifo.
+    void flushDecimator()
+    {
+        float decimatedSample;
+        
+        for (int i = 0; i < decimator.getLengthInSamples() && fifoIndex < fftSize; i++)
+            if (decimator.process (0.0f, decimatedSample))
+                analysis->fifo[(size_t) fifoIndex++] = decimatedSample;
         
-        synthFrequency = index * indexMultiplierForFrequencyAquisition;
+        decimator.reset();
+    }
+    
+    /**
+     Private method tunes the synth to the frequency found in a grain and starts playing it:
+     
+     Set the tuned frequency to the synth, recalibrate envelope parameters, reset the sample count to 0.
+     */
+    void startNote (float frequency)
+    {
+        synthFrequency = frequency;
         float adjustedFreq = adjustedFrequency (synthFrequency, precision, freqA);
+        noteFrequency = adjustedFreq;
         
         //set it to the synth
         triOsc.setFrequency (adjustedFreq);
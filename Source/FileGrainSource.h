@@ -0,0 +1,593 @@
+/*
+  ==============================================================================
+
+    FileGrainSource.h
+    Created: 18 Oct 2026 2:03:48am
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#if JUCE_LINUX || JUCE_MAC || JUCE_BSD
+ #include <sys/mman.h>
+ #define TABBOULEH_CAN_LOCK_PAGES 1
+#else
+ #define TABBOULEH_CAN_LOCK_PAGES 0
+#endif
+
+/**
+ An audio file for the grains to read from instead of the live input. It is decoded once into a memory mapped cache, so
+ that a file of hundreds of MB only takes the memory of the part the grains are playing.
+
+ A background thread, one per instance, does everything that can block:
+ - loading: the file is decoded, resampled to the project's rate, and written into a cache file in the temporary
+   folder as interleaved stereo floats. The cache file is then memory mapped and handed over to the audio thread,
+   which takes it up at the start of a block, the way ConvolutionReverb takes up its convolvers.
+ - prefetching: the audio thread publishes the region of the file the grains read from. The thread brings the chunks
+   of the cache covering that region, and where it is heading, into memory, and locks them there. Chunks the region
+   has left behind are let go of, once the audio thread can no longer be reading them.
+
+ The audio thread only reads chunks marked as resident, and reads silence from the others, so a page fault never
+ reaches it. A chunk is only resident once locked: when the system's limit on locked memory is reached, the chunks
+ wanted least recently are let go of to make room, and a region wider than the limit plays silence where it doesn't
+ fit. Where pages can't be locked at all, chunks are resident once faulted in. Offline, where waiting on the disk is
+ fine, every chunk is read.
+ */
+class FileGrainSource  : private juce::Thread
+{
+public:
+    static constexpr int chunkSizeInFrames = 16384;             // 128 KB of interleaved stereo floats
+    static constexpr double maxLengthInSeconds = 3600.0;
+    static constexpr double lookaheadSeconds = 0.5;             // How far ahead of a moving region to prefetch
+    static constexpr double keepSeconds = 2.0;                  // How long chunks stay in memory once left behind
+    static constexpr int prefetchIntervalMs = 10;
+
+    enum class Status
+    {
+        empty,
+        loading,
+        ready,
+        failed
+    };
+
+    FileGrainSource() : juce::Thread ("Tabbouleh file source")
+    {
+    }
+
+    ~FileGrainSource() override
+    {
+        stopThread (4000);
+        delete incoming.exchange (nullptr);
+        delete retired.exchange (nullptr);
+        delete active;
+    }
+
+    //==========================================================================
+    /**
+     Sets the rate of the project, decoding the file again if it changed. Call from prepareToPlay, while the audio
+     thread isn't running.
+
+     @param _sampleRate sample rate of the project
+     */
+    void prepare (double _sampleRate)
+    {
+        juce::File file;
+
+        {
+            const juce::ScopedLock lock (requestLock);
+
+            if (_sampleRate == sampleRate)
+                return;
+
+            sampleRate = _sampleRate;
+            file = requestedFile;
+        }
+
+        if (file != juce::File())
+            loadFile (file);
+    }
+
+    /**
+     Message thread: starts loading a file in the background, and returns straight away. The file last loaded is
+     played until the new one is ready.
+
+     @param file any audio file the AudioFormatManager can read, mono or stereo
+     */
+    void loadFile (const juce::File& file)
+    {
+        {
+            const juce::ScopedLock lock (requestLock);
+            requestedFile = file;
+            hasRequest = true;
+            status = Status::loading;
+            loadFinished.reset();
+        }
+
+        startThread();
+        notify();
+    }
+
+    /// Message thread: stops reading from the file.
+    void clearFile()
+    {
+        loadFile (juce::File());
+    }
+
+    /// Message thread: the file last asked for, or an empty File if there isn't one.
+    juce::File getFile() const
+    {
+        const juce::ScopedLock lock (requestLock);
+        return requestedFile;
+    }
+
+    /// Any thread: where loading the last file asked for is at.
+    Status getStatus() const
+    {
+        return status;
+    }
+
+    /**
+     Waits for the last file asked for to be loaded, for offline renders that must not start without it.
+
+     @return true if the file is ready
+     */
+    bool waitUntilLoaded (int timeoutMilliseconds)
+    {
+        return loadFinished.wait (timeoutMilliseconds) && status == Status::ready;
+    }
+
+    //==========================================================================
+    /// Audio thread: takes up a newly loaded file, if any. Returns true if there is a file to read from.
+    bool update()
+    {
+        // The old cache is only handed back once the last one has been deleted:
+        if (incoming.load() != nullptr && retired.load() == nullptr)
+        {
+            retired.store (active);
+            active = incoming.exchange (nullptr);
+        }
+
+        blockCount.fetch_add (1, std::memory_order_release);
+        return active != nullptr && active->numFrames > 0;
+    }
+
+    /// Audio thread: length of the file read from, in frames at the project's rate. Only valid when update() is true.
+    juce::int64 getNumFrames() const
+    {
+        return active->numFrames;
+    }
+
+    /**
+     Audio thread: tells the prefetcher where the grains read from, once per block.
+
+     @param start first frame of the region, wrapped around the length of the file
+     @param length length of the region, in frames
+     */
+    void setRegion (juce::int64 start, int length)
+    {
+        regionStart.store (start, std::memory_order_relaxed);
+        regionLength.store (length, std::memory_order_relaxed);
+    }
+
+    /// Audio thread: reads every chunk, resident or not, when waiting on the disk is fine.
+    void setNonRealtime (bool isNonRealtime)
+    {
+        nonRealtime = isNonRealtime;
+    }
+
+    /**
+     Audio thread: reads a frame of the file. Only call it when update() returned true.
+
+     @param position frame to read, wrapped around the length of the file
+     @param left receives the Left sample
+     @param right receives the Right sample
+     @return false if the frame isn't in memory yet, in which case both samples are left as they were
+     */
+    bool read (juce::int64 position, float& left, float& right) const
+    {
+        position %= active->numFrames;
+
+        if (position < 0)
+            position += active->numFrames;
+
+        if (! nonRealtime && ! active->resident[(size_t) (position / chunkSizeInFrames)].load (std::memory_order_acquire))
+            return false;
+
+        auto* frame = active->frames + 2 * position;
+        left = frame[0];
+        right = frame[1];
+        return true;
+    }
+
+    //==========================================================================
+private:
+    /// A decoded file, memory mapped. Deleting it unlocks its pages, unmaps it and deletes the cache file.
+    struct Cache
+    {
+        ~Cache()
+        {
+            for (int chunk = 0; chunk < numChunks; chunk++)
+                if (locked[(size_t) chunk])
+                    unlockChunk (*this, chunk);
+
+            map.reset();
+
+            if (file != juce::File())
+                file.deleteFile();
+        }
+
+        juce::File file;
+        std::unique_ptr<juce::MemoryMappedFile> map;
+        const float* frames = nullptr;
+        juce::int64 numFrames = 0;
+        int numChunks = 0;
+        std::unique_ptr<std::atomic<bool>[]> resident;          // Read by the audio thread
+
+        // Background thread only:
+        std::vector<bool> locked;
+        int numLocked = 0;
+        std::vector<double> lastWantedTime;                     // When the region last covered each chunk
+        std::vector<std::pair<int, juce::uint32>> pendingUnlocks;   // Chunks no longer resident, and the block then
+    };
+
+    // Message thread and background thread, under requestLock:
+    juce::CriticalSection requestLock;
+    juce::File requestedFile;
+    bool hasRequest = false;
+    std::atomic<Status> status { Status::empty };
+    juce::WaitableEvent loadFinished { true };
+    double sampleRate = 44100.0;
+
+    // Background thread:
+    Cache* latest = nullptr;                                    // Last cache handed over, the one to prefetch for
+    juce::int64 lastRegionStart = 0;
+    double lastRegionTime = 0.0;
+    int maxLockedChunks = std::numeric_limits<int>::max();     // Learnt from the first lock the system refuses
+
+    // Audio thread, handed over through incoming and retired:
+    Cache* active = nullptr;
+    std::atomic<Cache*> incoming { nullptr };
+    std::atomic<Cache*> retired { nullptr };
+    std::atomic<juce::int64> regionStart { 0 };
+    std::atomic<int> regionLength { 0 };
+    std::atomic<juce::uint32> blockCount { 0 };
+    bool nonRealtime = false;
+
+    //==========================================================================
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            juce::File fileToLoad;
+            double rate = 0.0;
+            bool shouldLoad = false;
+
+            {
+                const juce::ScopedLock lock (requestLock);
+                std::swap (shouldLoad, hasRequest);
+                fileToLoad = requestedFile;
+                rate = sampleRate;
+            }
+
+            if (shouldLoad)
+                load (fileToLoad, rate);
+
+            delete retired.exchange (nullptr);
+            prefetch();
+            wait (prefetchIntervalMs);
+        }
+    }
+
+    /// Decodes a file and hands it over, or hands over nothing for an empty File.
+    void load (const juce::File& file, double rate)
+    {
+        if (file == juce::File())
+        {
+            handOver (nullptr);
+            finishLoading (Status::empty);
+            return;
+        }
+
+        auto cache = decode (file, rate);
+
+        // A newer request cancels this one, and is loaded next:
+        if (hasNewRequest() || threadShouldExit())
+            return;
+
+        auto loaded = cache != nullptr;
+
+        if (loaded)
+            handOver (std::move (cache));
+
+        finishLoading (loaded ? Status::ready : Status::failed);
+    }
+
+    /// Tells the waiting threads the load is over, unless a newer request came in, which is then the one to wait for.
+    void finishLoading (Status newStatus)
+    {
+        const juce::ScopedLock lock (requestLock);
+
+        if (hasRequest)
+            return;
+
+        status = newStatus;
+        loadFinished.signal();
+    }
+
+    bool hasNewRequest() const
+    {
+        const juce::ScopedLock lock (requestLock);
+        return hasRequest;
+    }
+
+    /// Passes a cache, or an empty one to stop reading, to the audio thread.
+    void handOver (std::unique_ptr<Cache> cache)
+    {
+        if (cache == nullptr)
+            cache.reset (new Cache());
+
+        latest = cache.get();
+        lastRegionTime = 0.0;
+        maxLockedChunks = std::numeric_limits<int>::max();
+        delete incoming.exchange (cache.release());
+    }
+
+    /**
+     Decodes a file into a new cache file, resampled to the project's rate, and maps it.
+
+     @param rate sample rate of the project when the file was asked for
+     @return nullptr if the file couldn't be read, or loading was cancelled
+     */
+    std::unique_ptr<Cache> decode (const juce::File& file, double rate)
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+        std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (file));
+
+        if (reader == nullptr || reader->lengthInSamples <= 0)
+            return nullptr;
+
+        auto cache = std::make_unique<Cache>();
+        cache->file = juce::File::getSpecialLocation (juce::File::tempDirectory).getNonexistentChildFile ("Tabbouleh cache", ".raw");
+
+        auto inputLength = std::min (reader->lengthInSamples, (juce::int64) (maxLengthInSeconds * reader->sampleRate));
+        auto ratio = reader->sampleRate / rate;
+        auto outputLength = std::max ((juce::int64) 1, (juce::int64) (inputLength / ratio));
+
+        {
+            juce::FileOutputStream stream (cache->file);
+
+            if (stream.failedToOpen())
+                return nullptr;
+
+            // Linear resampling, a block of input at a time, with one more sample to interpolate towards:
+            constexpr int blockSize = 65536;
+            juce::AudioBuffer<float> input (2, blockSize + 1);
+            std::vector<float> interleaved;
+            juce::int64 outputPosition = 0;
+
+            for (juce::int64 blockStart = 0; blockStart < inputLength; blockStart += blockSize)
+            {
+                if (hasNewRequest() || threadShouldExit())
+                    return nullptr;
+
+                auto numInput = (int) std::min ((juce::int64) blockSize, inputLength - blockStart);
+                reader->read (&input, 0, numInput + 1, blockStart, true, true);
+
+                if (reader->numChannels == 1)
+                    input.copyFrom (1, 0, input, 0, 0, numInput + 1);
+
+                interleaved.clear();
+
+                for (; outputPosition < outputLength; outputPosition++)
+                {
+                    auto position = outputPosition * ratio - (double) blockStart;
+                    auto index = (int) position;
+
+                    if (index >= numInput)
+                        break;
+
+                    auto fraction = (float) (position - index);
+
+                    for (int channel = 0; channel < 2; channel++)
+                    {
+                        auto* samples = input.getReadPointer (channel);
+                        interleaved.push_back (samples[index] + fraction * (samples[index + 1] - samples[index]));
+                    }
+                }
+
+                if (! stream.write (interleaved.data(), interleaved.size() * sizeof (float)))
+                    return nullptr;
+            }
+
+            stream.flush();
+        }
+
+        cache->map = std::make_unique<juce::MemoryMappedFile> (cache->file, juce::MemoryMappedFile::readOnly);
+
+        if (cache->map->getData() == nullptr)
+            return nullptr;
+
+        cache->frames = static_cast<const float*> (cache->map->getData());
+        cache->numFrames = (juce::int64) (cache->map->getSize() / (2 * sizeof (float)));
+        cache->numChunks = (int) ((cache->numFrames + chunkSizeInFrames - 1) / chunkSizeInFrames);
+        cache->resident.reset (new std::atomic<bool>[(size_t) cache->numChunks]);
+        cache->locked.assign ((size_t) cache->numChunks, false);
+        cache->lastWantedTime.assign ((size_t) cache->numChunks, 0.0);
+
+        for (int chunk = 0; chunk < cache->numChunks; chunk++)
+            cache->resident[(size_t) chunk] = false;
+
+        if (cache->numFrames == 0)
+            return nullptr;
+
+        return cache;
+    }
+
+    //==========================================================================
+    /// Brings the chunks the grains read from, or are heading to, into memory, and lets go of those left behind.
+    void prefetch()
+    {
+        auto* cache = latest;
+
+        if (cache == nullptr || cache->numChunks == 0)
+            return;
+
+        auto now = juce::Time::getMillisecondCounterHiRes() * 0.001;
+        auto start = regionStart.load (std::memory_order_relaxed);
+        auto length = (juce::int64) regionLength.load (std::memory_order_relaxed);
+
+        // Where the region is heading, from how far it moved since the last pass:
+        juce::int64 ahead = 0;
+
+        if (lastRegionTime > 0.0 && now > lastRegionTime)
+            ahead = (juce::int64) ((start - lastRegionStart) / (now - lastRegionTime) * lookaheadSeconds);
+
+        lastRegionStart = start;
+        lastRegionTime = now;
+
+        // The region and where it is heading, wrapped around the end of the file:
+        auto first = start + std::min ((juce::int64) 0, ahead);
+        auto remaining = std::min (length + std::abs (ahead), cache->numFrames);
+        auto segmentStart = ((first % cache->numFrames) + cache->numFrames) % cache->numFrames;
+
+        while (remaining > 0)
+        {
+            auto segmentLength = std::min (remaining, cache->numFrames - segmentStart);
+            auto lastChunk = (int) ((segmentStart + segmentLength - 1) / chunkSizeInFrames);
+
+            for (auto chunk = (int) (segmentStart / chunkSizeInFrames); chunk <= lastChunk; chunk++)
+            {
+                cache->lastWantedTime[(size_t) chunk] = now;
+
+                if (! cache->resident[(size_t) chunk].load (std::memory_order_relaxed) && loadChunk (*cache, chunk, now))
+                    cache->resident[(size_t) chunk].store (true, std::memory_order_release);
+
+                if (threadShouldExit() || hasNewRequest())
+                    return;
+            }
+
+            remaining -= segmentLength;
+            segmentStart = 0;
+        }
+
+        for (int chunk = 0; chunk < cache->numChunks; chunk++)
+            if (cache->resident[(size_t) chunk].load (std::memory_order_relaxed) && now - cache->lastWantedTime[(size_t) chunk] > keepSeconds)
+                releaseChunk (*cache, chunk);
+
+        // Chunks released are unlocked once the audio thread has started two more blocks, so that no block that could
+        // still be reading them is running:
+        auto blocks = blockCount.load (std::memory_order_acquire);
+        auto& pending = cache->pendingUnlocks;
+
+        pending.erase (std::remove_if (pending.begin(), pending.end(), [&] (const std::pair<int, juce::uint32>& unlock)
+        {
+            if (blocks - unlock.second < 2)
+                return false;
+
+            // A chunk wanted again in the meantime is resident, and stays locked:
+            if (! cache->resident[(size_t) unlock.first].load (std::memory_order_relaxed) && cache->locked[(size_t) unlock.first])
+                unlockChunk (*cache, unlock.first);
+
+            return true;
+        }), pending.end());
+    }
+
+    /// Stops the audio thread reading a chunk, and unlocks it once no block can still be reading it.
+    void releaseChunk (Cache& cache, int chunk)
+    {
+        cache.resident[(size_t) chunk].store (false, std::memory_order_release);
+        cache.pendingUnlocks.push_back ({ chunk, blockCount.load (std::memory_order_acquire) });
+    }
+
+    /**
+     Faults every page of a chunk in, and locks them in memory. Past the system's limit, the chunk wanted least
+     recently, and not wanted now, is released to make room for a later pass.
+
+     @param now time of this prefetching pass, in seconds
+     @return true if the chunk can be read by the audio thread
+     */
+    bool loadChunk (Cache& cache, int chunk, double now)
+    {
+        // Released, but wanted again before it was unlocked:
+        if (cache.locked[(size_t) chunk])
+            return true;
+
+       #if TABBOULEH_CAN_LOCK_PAGES
+        // Chunks released but still locked will make room once unlocked:
+        auto numLeaving = (int) std::count_if (cache.pendingUnlocks.begin(), cache.pendingUnlocks.end(), [&] (const std::pair<int, juce::uint32>& unlock)
+        {
+            return cache.locked[(size_t) unlock.first] && ! cache.resident[(size_t) unlock.first].load (std::memory_order_relaxed);
+        });
+
+        if (cache.numLocked - numLeaving >= maxLockedChunks)
+        {
+            releaseLeastRecentChunk (cache, now);
+            return false;
+        }
+       #endif
+
+        auto* data = reinterpret_cast<const char*> (cache.frames + 2 * (juce::int64) chunk * chunkSizeInFrames);
+        auto size = getChunkSizeInBytes (cache, chunk);
+
+        volatile char sum = 0;
+
+        for (size_t offset = 0; offset < size; offset += 4096)
+            sum += data[offset];
+
+       #if TABBOULEH_CAN_LOCK_PAGES
+        // A touched page can still be evicted, so a chunk that can't be locked isn't read:
+        if (mlock (data, size) != 0)
+        {
+            maxLockedChunks = std::max (1, cache.numLocked);
+            releaseLeastRecentChunk (cache, now);
+            return false;
+        }
+
+        cache.locked[(size_t) chunk] = true;
+        cache.numLocked++;
+       #endif
+
+        return true;
+    }
+
+    /// Releases the resident chunk wanted least recently, unless every resident chunk is wanted by this pass.
+    void releaseLeastRecentChunk (Cache& cache, double now)
+    {
+        int oldest = -1;
+
+        for (int chunk = 0; chunk < cache.numChunks; chunk++)
+            if (cache.resident[(size_t) chunk].load (std::memory_order_relaxed) && cache.lastWantedTime[(size_t) chunk] < now
+                 && (oldest < 0 || cache.lastWantedTime[(size_t) chunk] < cache.lastWantedTime[(size_t) oldest]))
+                oldest = chunk;
+
+        if (oldest >= 0)
+            releaseChunk (cache, oldest);
+    }
+
+    static void unlockChunk (Cache& cache, int chunk)
+    {
+       #if TABBOULEH_CAN_LOCK_PAGES
+        munlock (cache.frames + 2 * (juce::int64) chunk * chunkSizeInFrames, getChunkSizeInBytes (cache, chunk));
+       #endif
+
+        cache.locked[(size_t) chunk] = false;
+        cache.numLocked--;
+    }
+
+    static size_t getChunkSizeInBytes (const Cache& cache, int chunk)
+    {
+        auto numFrames = std::min ((juce::int64) chunkSizeInFrames, cache.numFrames - (juce::int64) chunk * chunkSizeInFrames);
+        return (size_t) numFrames * 2 * sizeof (float);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (FileGrainSource)
+};
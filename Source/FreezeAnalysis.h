@@ -0,0 +1,313 @@
+/*
+  ==============================================================================
+
+    FreezeAnalysis.h
+    Created: 18 Oct 2026 5:52:14pm
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+#include "GrainBuffer.h"
+#include "Oscillator.h"
+#include "CustomFunctions.h"
+#include "DSPTables.h"
+#include "MyFilters.h"
+#include "FFTSynth.h"
+
+/**
+ Analysis of a frozen GrainBuffer, worked out once so that the FFTSynths can look it up instead of running their FFT
+ on the same audio over and over.
+
+ The frozen region is cut into frames of hopSize samples. For each of them it holds what an FFTSynth would find when
+ listenning to a grain starting there: the peak level of the first 20 ms under the same hann window, and the peak
+ frequency found by FFTSynth::findPeakFrequency once the window is brought down to FFTSynth::analysisRate by a
+ Decimator, as the voices do. It also holds the energy of the frame and whether it starts with an onset, and the
+ onsets can be searched as in an OnsetIndex.
+
+ The analysis goes through these states:
+ - idle: nothing to look up,
+ - requested: the buffer was just frozen, waiting for the analysis to start,
+ - analysing: running in the background, reading the frozen buffer,
+ - ready: frames can be looked up.
+
+ The audio thread calls request() when freezing and release() when unfreezing, and must keep the buffer frozen until
+ release() returns true. The message thread starts the analysis with launchIfRequested(); offline, the audio thread
+ can run it straight away with analyseIfRequested().
+ */
+class FreezeAnalysis
+{
+public:
+
+    /// What an FFTSynth would find in a grain starting at the frame.
+    struct Frame
+    {
+        float frequency = 0.0f;             // Peak frequency of the windowed grain start, in Hz
+        float peak = 0.0f;                  // Highest absolute sample of the windowed grain start
+        float energy = 0.0f;                // Mean square of the frame
+        bool isOnset = false;               // True if the energy jumps up at this frame
+    };
+
+    /// The background thread shared by every instance, through a juce::SharedResourcePointer.
+    struct BackgroundThread  : public juce::ThreadPool
+    {
+        BackgroundThread() : juce::ThreadPool (1) {}
+    };
+
+    static constexpr int hopSize = 256;
+
+    FreezeAnalysis (GrainBuffer& _grainBuffer) : grainBuffer (_grainBuffer), job (*this), fft (tables->getFFT (FFTSynth::fftOrder))
+    {
+    }
+
+    /**
+     Allocates the frames for the longest possible buffer. Call from prepareToPlay, while no analysis is running.
+
+     @param _sampleRate sample rate of project
+     @param maxBufferSizeInSamples maximum size of the GrainBuffer
+     */
+    void prepare (int _sampleRate, int maxBufferSizeInSamples)
+    {
+        sampleRate = _sampleRate;
+        frames.assign ((size_t) (maxBufferSizeInSamples / hopSize + 1), Frame());
+        onsets.assign (frames.size(), 0);
+        numOnsets = 0;
+        fftData.assign ((size_t) FFTSynth::fftSize * 2, 0.0f);
+        decimator.prepare (sampleRate, FFTSynth::analysisRate);
+        numFrames = 0;
+        state = idle;
+    }
+
+    //==========================================================================
+    /**
+     Audio thread: the buffer has just been frozen.
+
+     @param band band the FFTSynths listen to, kept for the whole analysis
+     */
+    void request (const AnalysisBand& band)
+    {
+        // Only the audio thread leaves idle, so nothing reads the band until the state changes:
+        if (state.load() != idle)
+            return;
+
+        analysisBand = band;
+        auto expected = (int) idle;
+        state.compare_exchange_strong (expected, (int) requested);
+    }
+
+    /**
+     Audio thread: the buffer should be unfrozen. Cancels any running analysis.
+
+     @return true once the analysis no longer reads the buffer, and the buffer can be written to again
+     */
+    bool release()
+    {
+        auto expected = (int) requested;
+
+        if (state.compare_exchange_strong (expected, (int) idle))
+            return true;
+
+        if (expected == analysing)
+        {
+            shouldCancel = true;
+            return false;
+        }
+
+        state = idle;
+        return true;
+    }
+
+    /// Message thread: starts the analysis on the shared background thread if it was requested.
+    void launchIfRequested (juce::ThreadPool& pool)
+    {
+        auto expected = (int) requested;
+
+        if (state.compare_exchange_strong (expected, (int) analysing))
+        {
+            shouldCancel = false;
+            pool.addJob (&job, false);
+        }
+    }
+
+    /// Audio thread, offline only: runs the analysis straight away if it was requested.
+    void analyseIfRequested()
+    {
+        auto expected = (int) requested;
+
+        if (state.compare_exchange_strong (expected, (int) analysing))
+        {
+            shouldCancel = false;
+            state = analyse() ? ready : idle;
+        }
+    }
+
+    /// Waits for the background analysis to stop, to be called before destruction.
+    void stop (juce::ThreadPool& pool)
+    {
+        shouldCancel = true;
+        pool.removeJob (&job, true, -1);
+    }
+
+    /// Returns true if frames can be looked up.
+    bool isReady() const
+    {
+        return state.load (std::memory_order_acquire) == ready;
+    }
+
+    /// Returns the frame a grain reading from readPos falls in. Only valid when isReady().
+    const Frame& getFrameAt (int readPos) const
+    {
+        return frames[(size_t) juce::jlimit (0, numFrames - 1, readPos / hopSize)];
+    }
+
+    int getNumFrames() const
+    {
+        return numFrames;
+    }
+
+    /**
+     Finds the onset mark closest to a position, as OnsetIndex::findNearest does while the buffer is written to. Only
+     valid when isReady().
+
+     @param position position to search around
+     @param maxDistance furthest the onset can be from the position, in samples
+     @param endPosition first position past the part of the buffer being read, ignoring onsets from there on
+     @return the position of the onset, or -1 if there isn't one close enough
+     */
+    int findNearestOnset (int position, int maxDistance, int endPosition) const
+    {
+        // First onset at or after the position, the nearest is either it or the one before:
+        auto end = onsets.begin() + numOnsets;
+        auto after = std::lower_bound (onsets.begin(), end, position);
+        int nearest = -1;
+        int nearestDistance = maxDistance + 1;
+
+        for (auto onset = after == onsets.begin() ? after : after - 1; onset != end && onset <= after; onset++)
+        {
+            auto distance = std::abs (*onset - position);
+
+            if (*onset < endPosition && distance < nearestDistance)
+            {
+                nearest = *onset;
+                nearestDistance = distance;
+            }
+        }
+
+        return nearest;
+    }
+
+    //==========================================================================
+private:
+    enum State
+    {
+        idle = 0,
+        requested,
+        analysing,
+        ready
+    };
+
+    struct AnalysisJob  : public juce::ThreadPoolJob
+    {
+        AnalysisJob (FreezeAnalysis& _owner) : juce::ThreadPoolJob ("Freeze analysis"), owner (_owner) {}
+
+        JobStatus runJob() override
+        {
+            auto finished = owner.analyse();
+            owner.state.store (finished ? ready : idle, std::memory_order_release);
+            return jobHasFinished;
+        }
+
+        FreezeAnalysis& owner;
+    };
+
+    GrainBuffer& grainBuffer;
+    AnalysisJob job;
+    juce::SharedResourcePointer<DSPTables> tables;
+    const juce::dsp::FFT& fft;
+    std::vector<float> fftData;
+    Decimator decimator;
+    AnalysisBand analysisBand;                          // The FFTSynths' band at the time of freezing
+    std::vector<Frame> frames;
+    int numFrames = 0;
+    std::vector<int> onsets;                            // Start of every frame marked as an onset, in order
+    int numOnsets = 0;
+    int sampleRate = 44100;
+    std::atomic<int> state { idle };
+    std::atomic<bool> shouldCancel { false };
+
+    /**
+     Analyses every frame of the frozen region, up to the buffer's maximum read position.
+
+     @return false if cancelled before the end
+     */
+    bool analyse()
+    {
+        int length = (int) grainBuffer.getMaxReadPos();
+        int numFramesToAnalyse = std::min ((int) frames.size(), length / hopSize + 1);
+        int windowLength = sampleRate / 50;                 // Half a period of the FFTSynth's 25 Hz hann oscillator
+        float previousEnergy = 0.0f;
+        numOnsets = 0;
+
+        SineOsc sinOscForHann;
+        sinOscForHann.setSampleRate (sampleRate);
+        sinOscForHann.setFrequency (25.0f);
+
+        for (int frameIndex = 0; frameIndex < numFramesToAnalyse; frameIndex++)
+        {
+            if (shouldCancel || job.shouldExit())
+                return false;
+
+            auto& frame = frames[(size_t) frameIndex];
+            int start = frameIndex * hopSize;
+
+            // Listen to a grain starting here, as FFTSynth::writeInSamples does:
+            std::fill (fftData.begin(), fftData.end(), 0.0f);
+            sinOscForHann.setPhase (0.0f);
+            decimator.reset();
+            frame.peak = 0.0f;
+            int numDecimated = 0;
+            float decimatedSample;
+
+            for (int i=0; i<windowLength; i++)
+            {
+                int index = (start + i) % std::max (length, 1);     // Grains go back to the start at the end of the region
+                float hannToBeSquared = sinOscForHann.process();
+                float monoSample = (grainBuffer.readValL (index) + grainBuffer.readValR (index)) * 0.5f * hannToBeSquared * hannToBeSquared;
+
+                if (decimator.process (monoSample, decimatedSample) && numDecimated < FFTSynth::fftSize)
+                    fftData[(size_t) numDecimated++] = decimatedSample;
+
+                frame.peak = std::max (frame.peak, std::abs (monoSample));
+            }
+
+            // Let the decimator ring out, as FFTSynth::flushDecimator does:
+            for (int i=0; i<decimator.getLengthInSamples() && numDecimated < FFTSynth::fftSize; i++)
+                if (decimator.process (0.0f, decimatedSample))
+                    fftData[(size_t) numDecimated++] = decimatedSample;
+
+            frame.frequency = FFTSynth::findPeakFrequency (fft, fftData.data(), analysisBand, decimator.getOutputRate());
+
+            // Energy of the frame itself, and onsets where it more than doubles:
+            float energy = 0.0f;
+            int frameEnd = std::min (start + hopSize, length);
+
+            for (int i=start; i<frameEnd; i++)
+                energy += grainBuffer.readValL (i) * grainBuffer.readValL (i) + grainBuffer.readValR (i) * grainBuffer.readValR (i);
+
+            frame.energy = frameEnd > start ? energy / (2.0f * (frameEnd - start)) : 0.0f;
+            frame.isOnset = frame.energy > 1.0e-6f && frame.energy > 2.0f * previousEnergy;
+            previousEnergy = frame.energy;
+
+            if (frame.isOnset)
+                onsets[(size_t) numOnsets++] = start;
+        }
+
+        numFrames = std::max (numFramesToAnalyse, 1);
+        return true;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (FreezeAnalysis)
+};
@@ -23,8 +23,11 @@
  instance, and moves the readPos to a new location.
  
  Remember to intialise the class in prepareToPlay() by setting the sample rate.
+ 
+ The state used at every sample comes first and the class is aligned on cache lines, so that grains kept side by side
+ in a vector never share a cache line, and the random generator only used when a grain starts sits at the end.
  */
-class Grain
+class alignas (64) Grain
 {
 public:
      
@@ -92,12 +95,28 @@ public:
         
     }
     
+    /// Returns true if the current grain was skipped, and plays silence.
+    bool isSkipped() const
+    {
+        return skippedGrainVolume == 0.0f;
+    }
+    
     /// Returns the sample of the buffer to read from.
     float getReadPos()
     {
         return readPos;
     }
     
+    /**
+     Moves the grain to another sample of the buffer, such as a nearby onset when a new grain starts.
+     
+     @param position sample of the buffer to read from, below the max read position
+     */
+    void setReadPos (int position)
+    {
+        readPos = position;
+    }
+    
     /// Returns the envelope coefficient at this sample for the grain.
     float getSampleEnvelope()
     {
@@ -153,18 +172,27 @@ public:
         return triRamp.newCycleStarted();
     }
     
+    /// Seeds the random choices of where grains start, which are skipped and where they sit in the stereo field.
+    void setRandomSeed (juce::int64 seed)
+    {
+        random.setSeed (seed);
+    }
+    
     //==========================================================================
 private:
-    int sampleRate;
-    juce::Random random;
+    // HOT, used at every sample:
     TriRamp triRamp;
     int readPos = 0;
-    bool timeToReset = false;
     int maxReadPos = 4410;      //initialisation to be overriden before playback in process method.
     float sampleEnvelope = 0.0f;
     float skippedGrainVolume = 1.0f;
     float stereoVolumeLeft = 1.0f;
     float stereoVolumeRight = 1.0f;
+    bool timeToReset = false;
+    
+    // COLD, used when a grain starts or the sample rate changes:
+    int sampleRate;
+    juce::Random random;
 };
 
 /**=============================================================================
@@ -10,50 +10,66 @@
 
 #pragma once
 
+#include "OnsetIndex.h"
+#include "HalfFloat.h"
+
 /**
  Class for an audio buffer designed to be used in conjunction with the Grain class.
  
  A grainBuffer instance houses a 2 channel buffer, whose size is flexible,
+ along with the index of the onsets it holds (see OnsetIndex).
+ 
+ The samples can be stored as half floats (see HalfFloat) rather than floats, halving the memory the buffer takes and
+ the bandwidth grains reading all over it use, for a signal to noise ratio above 70 dB at any usual level.
  */
 class GrainBuffer
 {
 public:
+    
+    /// How the samples are stored.
+    enum class Storage
+    {
+        float32,        // Exactly as written
+        float16         // Half the memory, rounded to 11 bits of mantissa
+    };
 
     /**
      acts as but isn't a constructor for GrainDelay class
      
      @param _maxDelayTime maximum length of buffers in seconds
      @param _sampleRate sample rate
+     @param _storage how the samples are stored
      */
-    void initialise (int _maxDelayTime, int _sampleRate)
+    void initialise (int _maxDelayTime, int _sampleRate, Storage _storage = Storage::float32)
     {
         // If buffers exist, delete them:
-        if (bufferL) delete[] bufferL;
-        if (bufferR) delete[] bufferR;
+        freeBuffers();
         
         // set variables:
         sampleRate = _sampleRate;
         maxSize = _maxDelayTime * _sampleRate;
         maxReadPos = maxSize;
+        storage = _storage;
         
-        // Create buffers:
-        bufferL = new float[maxSize];
-        bufferR = new float[maxSize];
-        
-        // populate buffers with 0:
-        for (int i=0; i<maxSize; i++)
+        // Create buffers, populated with 0 (which is 0 as a half float too):
+        if (storage == Storage::float16)
+        {
+            compactBufferL = new std::uint16_t[maxSize]();
+            compactBufferR = new std::uint16_t[maxSize]();
+        }
+        else
         {
-            bufferL[i] = 0.0f;
-            bufferR[i] = 0.0f;
+            bufferL = new float[maxSize]();
+            bufferR = new float[maxSize]();
         }
+        
+        onsetIndex.prepare (maxSize);
     }
     
     ///Destructor
     ~GrainBuffer()
     {
-        // If buffers exist, delete them:
-        if (bufferL) delete[] bufferL;
-        if (bufferR) delete[] bufferR;
+        freeBuffers();
     }
     
     
@@ -76,6 +92,10 @@ public:
      */
     void writeVal (float inputSampleL, float inputSampleR)
     {
+        // Frozen buffers keep their history:
+        if (frozen)
+            return;
+        
         // increment writing position:
         writePos++;
         
@@ -92,9 +112,18 @@ public:
         }
         
         // Write in samples:
-        bufferL[writePos] = inputSampleL;
-        bufferR[writePos] = inputSampleR;
+        if (storage == Storage::float16)
+        {
+            compactBufferL[writePos] = HalfFloat::fromFloat (inputSampleL);
+            compactBufferR[writePos] = HalfFloat::fromFloat (inputSampleR);
+        }
+        else
+        {
+            bufferL[writePos] = inputSampleL;
+            bufferR[writePos] = inputSampleR;
+        }
         
+        onsetIndex.write (writePos, inputSampleL, inputSampleR);
     }
     
     /**
@@ -103,9 +132,9 @@ public:
      @param index The reading position index [0-4]
      @return sample value at reading position
      */
-    float readValL (int index)
+    float readValL (int index) const
     {
-        return bufferL[index];
+        return storage == Storage::float16 ? HalfFloat::toFloat (compactBufferL[index]) : bufferL[index];
     }
     
     /**
@@ -114,17 +143,98 @@ public:
      @param index The reading position index [0-4]
      @return sample value at reading position
      */
-    float readValR (int index)
+    float readValR (int index) const
     {
-        return bufferR[index];
+        return storage == Storage::float16 ? HalfFloat::toFloat (compactBufferR[index]) : bufferR[index];
+    }
+    
+    /**
+     Writes silence, as numSamples calls to writeVal (0.0f, 0.0f) would, but filling whole stretches of the buffers at once.
+     
+     @param numSamples number of silent samples to write
+     */
+    void writeSilence (int numSamples)
+    {
+        if (frozen)
+            return;
+        
+        while (numSamples > 0)
+        {
+            // Samples that can be written before the writing position goes back to the start:
+            int numBeforeWrap = std::min (currentWriteSize, maxSize) - 1 - writePos;
+            
+            if (numBeforeWrap <= 0)
+            {
+                writeVal (0.0f, 0.0f);
+                numSamples--;
+                continue;
+            }
+            
+            int numToWrite = std::min (numSamples, numBeforeWrap);
+            
+            if (storage == Storage::float16)
+            {
+                std::fill (compactBufferL + writePos + 1, compactBufferL + writePos + 1 + numToWrite, (std::uint16_t) 0);
+                std::fill (compactBufferR + writePos + 1, compactBufferR + writePos + 1 + numToWrite, (std::uint16_t) 0);
+            }
+            else
+            {
+                std::fill (bufferL + writePos + 1, bufferL + writePos + 1 + numToWrite, 0.0f);
+                std::fill (bufferR + writePos + 1, bufferR + writePos + 1 + numToWrite, 0.0f);
+            }
+            
+            onsetIndex.writeSilence (writePos + 1, numToWrite);
+            writePos += numToWrite;
+            numSamples -= numToWrite;
+        }
+    }
+    
+    /// Returns the position the last sample was written at.
+    int getWritePos() const
+    {
+        return writePos;
     }
     
     /// Returns the maximum read position, indicating to grains when to return to the start of the buffer.
-    float getMaxReadPos()
+    float getMaxReadPos() const
     {
         return maxReadPos;
     }
     
+    /**
+     Freezes the buffer: while frozen, writes are ignored and the buffer keeps the audio it holds, for the grains to
+     play indefinitely.
+     
+     @param shouldBeFrozen true to freeze, false to start writing again
+     */
+    void setFrozen (bool shouldBeFrozen)
+    {
+        frozen = shouldBeFrozen;
+    }
+    
+    bool isFrozen() const
+    {
+        return frozen;
+    }
+    
+    /// Returns how the samples are stored.
+    Storage getStorage() const
+    {
+        return storage;
+    }
+    
+    /// Returns the memory taken by the samples of both channels, in bytes.
+    size_t getSizeInBytes() const
+    {
+        return 2 * (size_t) maxSize * (storage == Storage::float16 ? sizeof (std::uint16_t) : sizeof (float));
+    }
+    
+    /// Returns the index of the onsets in the buffer, to find transients around a read position.
+    const OnsetIndex& getOnsetIndex() const
+    {
+        return onsetIndex;
+    }
+    
     //==========================================================================
 private:
     
@@ -136,7 +246,24 @@ private:
     int maxSize;
     float* bufferL = nullptr;
     float* bufferR = nullptr;
+    std::uint16_t* compactBufferL = nullptr;       // Used in place of bufferL and bufferR when storing half floats
+    std::uint16_t* compactBufferR = nullptr;
+    Storage storage = Storage::float32;
     int writePos = 0;
+    bool frozen = false;
+    OnsetIndex onsetIndex;
+    
+    void freeBuffers()
+    {
+        delete[] bufferL;
+        delete[] bufferR;
+        delete[] compactBufferL;
+        delete[] compactBufferR;
+        bufferL = nullptr;
+        bufferR = nullptr;
+        compactBufferL = nullptr;
+        compactBufferR = nullptr;
+    }
 };
 
 
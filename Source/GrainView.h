@@ -0,0 +1,352 @@
+/*
+  ==============================================================================
+
+    GrainView.h
+    Created: 18 Oct 2026 7:51:30pm
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <vector>
+#include "Telemetry.h"
+#include "PerformanceCounters.h"
+
+/**
+ Shows what the engine is doing, from the events the audio thread publishes through Telemetry:
+ - the GrainBuffer's waveform, with its write position and each grain's read position, faded by its envelope,
+ - each FFTSynth voice, with the detected and tuned pitch of its last note and its envelope,
+ - once a second, the block time and analysis figures of the PerformanceCounters, if given.
+
+ The events are drained at a fixed frame rate on the message thread. The waveform is cached in an image in which only
+ the columns written since the last frame are redrawn, and only the parts of the component that changed are repainted.
+ */
+class GrainView  : public juce::Component,
+                   private juce::Timer
+{
+public:
+    static constexpr int numVoices = 5;
+    static constexpr int frameRate = 30;
+    static constexpr int voicePanelWidth = 190;
+
+    GrainView (Telemetry& _telemetry) : telemetry (_telemetry)
+    {
+        setOpaque (true);
+        telemetry.setActive (true);
+        startTimerHz (frameRate);
+    }
+
+    ~GrainView() override
+    {
+        telemetry.setActive (false);
+    }
+
+    /// Sets the function giving the current quality level, shown in the voice panel.
+    void setQualityLevelSource (std::function<int()> source)
+    {
+        getQualityLevel = std::move (source);
+    }
+    
+    /// Sets the counters summarised at the bottom of the voice panel.
+    void setPerformanceCounters (const PerformanceCounters* _counters)
+    {
+        counters = _counters;
+        
+        if (counters != nullptr)
+            lastSnapshot = counters->getSnapshot();
+    }
+
+    //==========================================================================
+    void paint (juce::Graphics& g) override
+    {
+        g.fillAll (juce::Colour (0xff1d2417));
+
+        // Waveform, from the cache:
+        g.drawImageAt (waveformImage, waveformBounds.getX(), waveformBounds.getY());
+
+        // Write position:
+        g.setColour (juce::Colours::white.withAlpha (0.6f));
+        g.drawVerticalLine ((int) positionToX (writePosition), (float) waveformBounds.getY(), (float) waveformBounds.getBottom());
+
+        // Grains, faded by their envelope:
+        for (int i=0; i<numVoices; i++)
+        {
+            auto colour = getVoiceColour (i).withAlpha (0.25f + 0.75f * grains[(size_t) i].envelope);
+            g.setColour (colour);
+            g.fillRect (getGrainMarkerBounds (grains[(size_t) i].position));
+        }
+
+        paintVoicePanel (g);
+    }
+
+    void resized() override
+    {
+        auto bounds = getLocalBounds();
+        voicePanelBounds = bounds.removeFromRight (voicePanelWidth);
+        waveformBounds = bounds.reduced (4);
+
+        columnPeaks.assign ((size_t) juce::jmax (1, waveformBounds.getWidth()), 0.0f);
+        waveformImage = juce::Image (juce::Image::RGB, juce::jmax (1, waveformBounds.getWidth()), juce::jmax (1, waveformBounds.getHeight()), true);
+        redrawColumns (0, (int) columnPeaks.size());
+    }
+
+    //==========================================================================
+private:
+    struct GrainDisplay
+    {
+        int position = 0;
+        float envelope = 0.0f;
+    };
+
+    struct VoiceDisplay
+    {
+        float detectedFrequency = 0.0f;
+        float tunedFrequency = 0.0f;
+        float volume = 0.0f;
+        float envelope = 0.0f;
+    };
+
+    Telemetry& telemetry;
+    std::function<int()> getQualityLevel;
+    const PerformanceCounters* counters = nullptr;
+    PerformanceCounters::Snapshot lastSnapshot;
+    PerformanceCounters::Report report;
+    int framesSinceReport = 0;
+
+    juce::Rectangle<int> waveformBounds, voicePanelBounds;
+    juce::Image waveformImage;
+    std::vector<float> columnPeaks;
+    int bufferLength = 1;
+    int writePosition = 0;
+    std::array<GrainDisplay, numVoices> grains;
+    std::array<VoiceDisplay, numVoices> voices;
+    int qualityLevel = 0;
+
+    static juce::Colour getVoiceColour (int voice)
+    {
+        static const juce::Colour colours[numVoices] = { juce::Colour (0xff8fd14f), juce::Colour (0xffe04f3a), juce::Colour (0xfff2c14e),
+                                                         juce::Colour (0xff5fb3c9), juce::Colour (0xffd98cc8) };
+        return colours[voice % numVoices];
+    }
+
+    float positionToX (int position) const
+    {
+        return waveformBounds.getX() + waveformBounds.getWidth() * (float) position / (float) bufferLength;
+    }
+
+    int positionToColumn (int position) const
+    {
+        return juce::jlimit (0, (int) columnPeaks.size() - 1, (int) ((juce::int64) position * (juce::int64) columnPeaks.size() / bufferLength));
+    }
+
+    juce::Rectangle<int> getGrainMarkerBounds (int position) const
+    {
+        return { (int) positionToX (position) - 1, waveformBounds.getY(), 3, waveformBounds.getHeight() };
+    }
+
+    juce::Rectangle<int> getVoiceBounds (int voice) const
+    {
+        auto voicesArea = voicePanelBounds.reduced (6).withTrimmedTop (20);
+        return voicesArea.withHeight (34).translated (0, voice * 34);
+    }
+    
+    juce::Rectangle<int> getCountersBounds() const
+    {
+        return voicePanelBounds.reduced (6, 4).removeFromBottom (30);
+    }
+
+    //==========================================================================
+    /// Drains the telemetry, then repaints whatever changed.
+    void timerCallback() override
+    {
+        // Not laid out yet, nothing to draw into:
+        if (columnPeaks.empty())
+        {
+            telemetry.drain ([] (const TelemetryEvent&) {});
+            return;
+        }
+
+        juce::RectangleList<int> dirty;
+        int firstDirtyColumn = (int) columnPeaks.size();
+        int lastDirtyColumn = -1;
+        std::array<bool, numVoices> voiceChanged {};
+
+        auto moveGrain = [&] (int voice, int position, float envelope)
+        {
+            auto& grain = grains[(size_t) voice];
+
+            if (grain.position == position && std::abs (grain.envelope - envelope) < 0.02f)
+                return;
+
+            dirty.add (getGrainMarkerBounds (grain.position));
+            grain.position = position;
+            grain.envelope = envelope;
+            dirty.add (getGrainMarkerBounds (grain.position));
+        };
+
+        telemetry.drain ([&] (const TelemetryEvent& event)
+        {
+            auto voice = juce::jlimit (0, numVoices - 1, (int) event.voice);
+
+            switch (event.type)
+            {
+                case TelemetryEvent::bufferWritten:
+                {
+                    auto newLength = juce::jmax (1, (int) event.value2);
+
+                    if (newLength != bufferLength)
+                    {
+                        bufferLength = newLength;
+                        firstDirtyColumn = 0;
+                        lastDirtyColumn = (int) columnPeaks.size() - 1;
+                        dirty.add (waveformBounds);         // Every marker moves
+                    }
+
+                    // Every column written since the last event takes the block's peak:
+                    auto fromColumn = positionToColumn (writePosition);
+                    auto toColumn = positionToColumn (event.position);
+                    auto column = fromColumn;
+
+                    while (true)
+                    {
+                        columnPeaks[(size_t) column] = event.value1;
+                        firstDirtyColumn = std::min (firstDirtyColumn, column);
+                        lastDirtyColumn = std::max (lastDirtyColumn, column);
+
+                        if (column == toColumn)
+                            break;
+
+                        column = (column + 1) % (int) columnPeaks.size();
+                    }
+
+                    dirty.add (getGrainMarkerBounds (writePosition));
+                    writePosition = event.position;
+                    dirty.add (getGrainMarkerBounds (writePosition));
+                    break;
+                }
+
+                case TelemetryEvent::grainStarted:
+                case TelemetryEvent::grainState:
+                    moveGrain (voice, event.position, event.type == TelemetryEvent::grainState ? event.value1 : grains[(size_t) voice].envelope);
+                    break;
+
+                case TelemetryEvent::synthNoteStarted:
+                    voices[(size_t) voice].detectedFrequency = event.value1;
+                    voices[(size_t) voice].tunedFrequency = event.value2;
+                    voices[(size_t) voice].volume = event.value3;
+                    voiceChanged[(size_t) voice] = true;
+                    break;
+
+                case TelemetryEvent::synthState:
+                    if (std::abs (voices[(size_t) voice].envelope - event.value1) >= 0.02f)
+                    {
+                        voices[(size_t) voice].envelope = event.value1;
+                        voiceChanged[(size_t) voice] = true;
+                    }
+                    break;
+
+                default:
+                    break;
+            }
+        });
+
+        if (lastDirtyColumn >= firstDirtyColumn)
+        {
+            redrawColumns (firstDirtyColumn, lastDirtyColumn + 1);
+            dirty.add ({ waveformBounds.getX() + firstDirtyColumn, waveformBounds.getY(), lastDirtyColumn + 1 - firstDirtyColumn, waveformBounds.getHeight() });
+        }
+
+        for (int i=0; i<numVoices; i++)
+            if (voiceChanged[(size_t) i])
+                dirty.add (getVoiceBounds (i));
+
+        if (getQualityLevel != nullptr && getQualityLevel() != qualityLevel)
+        {
+            qualityLevel = getQualityLevel();
+            dirty.add (voicePanelBounds.withHeight (24));
+        }
+        
+        if (counters != nullptr && ++framesSinceReport >= frameRate)
+        {
+            auto snapshot = counters->getSnapshot();
+            report = PerformanceCounters::compare (lastSnapshot, snapshot);
+            lastSnapshot = snapshot;
+            framesSinceReport = 0;
+            dirty.add (getCountersBounds());
+        }
+
+        for (auto& area : dirty)
+            repaint (area);
+    }
+
+    /// Redraws the columns of the cached waveform in the range [start, end).
+    void redrawColumns (int start, int end)
+    {
+        juce::Graphics g (waveformImage);
+        auto height = (float) waveformImage.getHeight();
+        auto centre = height * 0.5f;
+
+        g.setColour (juce::Colour (0xff1d2417));
+        g.fillRect (start, 0, end - start, waveformImage.getHeight());
+        g.setColour (juce::Colour (0xff6f8f4a));
+
+        for (int column = start; column < end; column++)
+        {
+            auto halfHeight = juce::jmin (1.0f, columnPeaks[(size_t) column]) * centre;
+            g.drawVerticalLine (column, centre - halfHeight, centre + halfHeight + 1.0f);
+        }
+    }
+
+    void paintVoicePanel (juce::Graphics& g)
+    {
+        g.setColour (juce::Colour (0xff262f1e));
+        g.fillRect (voicePanelBounds);
+
+        g.setColour (juce::Colours::white.withAlpha (0.8f));
+        g.setFont (13.0f);
+        g.drawText ("Chef's Shortcuts: " + juce::String (qualityLevel), voicePanelBounds.reduced (6, 0).withHeight (24),
+                    juce::Justification::centredLeft);
+
+        for (int i=0; i<numVoices; i++)
+        {
+            auto& voice = voices[(size_t) i];
+            auto bounds = getVoiceBounds (i).reduced (0, 2);
+
+            // Envelope bar behind the text:
+            g.setColour (getVoiceColour (i).withAlpha (0.2f));
+            g.fillRect (bounds);
+            g.setColour (getVoiceColour (i).withAlpha (0.7f));
+            g.fillRect (bounds.withWidth ((int) (bounds.getWidth() * juce::jlimit (0.0f, 1.0f, voice.envelope))));
+
+            g.setColour (juce::Colours::white);
+            g.setFont (12.0f);
+
+            if (voice.tunedFrequency > 0.0f)
+            {
+                auto noteNumber = juce::roundToInt (12.0f * std::log2 (voice.tunedFrequency / 440.0f)) + 69;
+                g.drawText (juce::MidiMessage::getMidiNoteName (noteNumber, true, true, 3)
+                              + "  " + juce::String (voice.tunedFrequency, 1) + " Hz"
+                              + "  (" + juce::String (voice.detectedFrequency, 1) + ")",
+                            bounds.reduced (4, 0), juce::Justification::centredLeft);
+            }
+        }
+        
+        if (counters != nullptr)
+        {
+            auto bounds = getCountersBounds();
+            g.setColour (juce::Colours::white.withAlpha (0.6f));
+            g.setFont (11.0f);
+            g.drawText ("Block p99: " + juce::String (report.blockMicroseconds99 * 0.001, 2) + " ms"
+                          + ", FFT: " + juce::String (juce::roundToInt (report.fftShareOfProcessing * 100.0)) + "%",
+                        bounds.removeFromTop (15), juce::Justification::centredLeft);
+            g.drawText ("Analyses: " + juce::String (juce::roundToInt (report.analysesPerSecond)) + "/s"
+                          + ", skipped grains: " + juce::String (juce::roundToInt (report.skippedGrainRate * 100.0)) + "%",
+                        bounds, juce::Justification::centredLeft);
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GrainView)
+};
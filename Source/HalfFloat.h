@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    HalfFloat.h
+    Created: 18 Oct 2026 1:12:06am
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// F16C is only there when the build asks for it (TABBOULEH_F16C in CMake, or the "Release F16C" configurations of the
+// jucers): MSVC has no macro of its own for it, and brings it with AVX2.
+#if defined (__F16C__) || (defined (_MSC_VER) && defined (__AVX2__))
+ #define TABBOULEH_HALF_FLOAT_F16C 1
+ #include <immintrin.h>
+#else
+ #define TABBOULEH_HALF_FLOAT_F16C 0
+#endif
+
+/**
+ Conversions between 32 bit floats and IEEE 754 half precision floats (float16), for audio kept in half the memory.
+
+ A half float keeps 11 bits of mantissa whatever the level of the sample, so quiet passages are stored as precisely as
+ loud ones: a signal to noise ratio above 70 dB from full scale down to -60 dBFS, and then a noise floor that stays
+ below -140 dBFS as the samples reach the subnormals. Conversions round to the nearest, ties to even.
+
+ The conversion instructions are used on AArch64, and on x86 when built with F16C, which is opt-in as older CPUs lack
+ it. Default x86 builds, and every other target, do the same rounding in plain integer code.
+ */
+namespace HalfFloat
+{
+    /// Converts a float to the nearest half float, saturating to infinity above 65504.
+    inline std::uint16_t fromFloat (float value)
+    {
+       #if TABBOULEH_HALF_FLOAT_F16C
+        return (std::uint16_t) _cvtss_sh (value, _MM_FROUND_TO_NEAREST_INT);
+       #elif defined (__aarch64__)
+        __fp16 half = (__fp16) value;
+        std::uint16_t bits;
+        std::memcpy (&bits, &half, sizeof (bits));
+        return bits;
+       #else
+        std::uint32_t bits;
+        std::memcpy (&bits, &value, sizeof (bits));
+
+        auto sign = (std::uint16_t) ((bits >> 16) & 0x8000u);
+        bits &= 0x7fffffffu;
+
+        // Too large, infinity or NaN:
+        if (bits >= 0x47800000u)
+            return (std::uint16_t) (sign | (bits > 0x7f800000u ? 0x7e00u : 0x7c00u));
+
+        // Subnormal halves: adding a float whose ulp is the smallest half leaves the rounded mantissa in the low bits:
+        if (bits < 0x38800000u)
+        {
+            const std::uint32_t magicBits = 0x3f000000u;     // 0.5f, whose ulp is 2^-24
+            float magic, sum;
+            std::memcpy (&magic, &magicBits, sizeof (magic));
+            std::memcpy (&sum, &bits, sizeof (sum));
+            sum += magic;
+
+            std::uint32_t sumBits;
+            std::memcpy (&sumBits, &sum, sizeof (sumBits));
+            return (std::uint16_t) (sign | (sumBits - magicBits));
+        }
+
+        // Normal halves: rebias the exponent, and round the 13 dropped bits to the nearest, ties to even:
+        auto mantissaIsOdd = (bits >> 13) & 1u;
+        bits += 0xc8000fffu + mantissaIsOdd;                // (15 - 127) << 23, plus the rounding
+        return (std::uint16_t) (sign | (bits >> 13));
+       #endif
+    }
+
+    /// Converts a half float to the float it stands for exactly.
+    inline float toFloat (std::uint16_t half)
+    {
+       #if TABBOULEH_HALF_FLOAT_F16C
+        return _cvtsh_ss (half);
+       #elif defined (__aarch64__)
+        __fp16 value;
+        std::memcpy (&value, &half, sizeof (half));
+        return (float) value;
+       #else
+        const std::uint32_t exponentMask = 0x7c00u << 13;
+        std::uint32_t bits = (std::uint32_t) (half & 0x7fffu) << 13;
+        auto exponent = bits & exponentMask;
+        bits += (127u - 15u) << 23;
+
+        float value;
+
+        if (exponent == exponentMask)
+        {
+            // Infinity or NaN:
+            bits += (128u - 16u) << 23;
+            std::memcpy (&value, &bits, sizeof (value));
+        }
+        else if (exponent == 0)
+        {
+            // Zero or subnormal, renormalised by the FPU:
+            const std::uint32_t magicBits = 113u << 23;
+            float magic;
+            bits += 1u << 23;
+            std::memcpy (&value, &bits, sizeof (value));
+            std::memcpy (&magic, &magicBits, sizeof (magic));
+            value -= magic;
+        }
+        else
+        {
+            std::memcpy (&value, &bits, sizeof (value));
+        }
+
+        return (half & 0x8000u) != 0 ? -value : value;
+       #endif
+    }
+
+    /// Names the conversions compiled in, for the benchmarks to report.
+    inline const char* getConversionName()
+    {
+       #if TABBOULEH_HALF_FLOAT_F16C
+        return "F16C";
+       #elif defined (__aarch64__)
+        return "AArch64";
+       #else
+        return "integer";
+       #endif
+    }
+}
@@ -9,7 +9,10 @@
 */
 
 #pragma once
+#include <JuceHeader.h>
 #include <cmath>
+#include <array>
+#include <vector>
 #include "Oscillator.h"
 
 /**
@@ -21,6 +24,36 @@ class MyFilter
 {
 public:
     
+    /// Coefficients of the low pass, y[n] = a0 x[n] + a1 x[n-1] + a2 x[n-2] - b1 y[n-1] - b2 y[n-2].
+    struct Coefficients
+    {
+        float a0, a1, a2, b1, b2;
+    };
+    
+    /**
+     Works out the coefficients of the resonant low pass.
+     
+     @param _sampleRate sample rate
+     @param _cutoffFrequency cutoff frequency, below half the sample rate
+     @param _Qres resonnance parameter [1-20]
+     */
+    static Coefficients makeLowPass (float _sampleRate, float _cutoffFrequency, float _Qres)
+    {
+        const float pi = 3.14159265359;
+        float theta = (2 * pi * _cutoffFrequency) / _sampleRate;
+        float inverseQ = 1.0 / std::max (_Qres, 1.0f);
+        float beta = 0.5f * (1 - ((inverseQ/2.0f) * sin (theta))) / (1 + ((inverseQ / 2.0f) * sin (theta)));
+        float gamma = (0.5 + beta) * cos (theta);
+        
+        Coefficients coefficients;
+        coefficients.a0 = (0.5 + beta - gamma) / 2.0;
+        coefficients.a1 = 2.0 * coefficients.a0;
+        coefficients.a2 = coefficients.a0;
+        coefficients.b1 = -2.0 * gamma;
+        coefficients.b2 = 2 * beta;
+        return coefficients;
+    }
+    
     //Constructor
     MyFilter (float _sampleRate, float _cutoffFrequency, float _Qres = 1.0)
     {
@@ -47,11 +80,13 @@ public:
         d = 1.0/Qres;
         beta = 0.5f * (1 - ((d/2.0f) * sin (thetaCutoff))) / (1 + ((d / 2.0f) * sin (thetaCutoff)));
         gamma = (0.5 + beta) * cos (thetaCutoff);
-        a0 = (0.5 + beta - gamma) / 2.0;
-        a1 = 2.0 * a0;
-        a2 = a0;
-        b1 = -2.0 * gamma;
-        b2 = 2 * beta;
+        
+        auto coefficients = makeLowPass (sampleRate, cutoffFrequency, Qres);
+        a0 = coefficients.a0;
+        a1 = coefficients.a1;
+        a2 = coefficients.a2;
+        b1 = coefficients.b1;
+        b2 = coefficients.b2;
     }
     
     //set cutoff frequency
@@ -139,6 +174,279 @@ private:
 };
 
 
+/**
+ A MyFilter low pass for every grain and channel, stepped together one sample at a time.
+ 
+ The filters are kept as a structure of arrays, one lane per filter: the Left channels of the grains in the first
+ half of the lanes, the Right channels in the second. Each sample, every lane is stepped at once through
+ juce::dsp::SIMDRegister, so the cost barely grows with the number of grains. Coefficients are only worked out when a
+ grain starts, with its cutoff and resonance randomised around the set ones, the way "Spices" randomises panning.
+ 
+ Every method is meant for the audio thread, and none of them allocate.
+ */
+class GrainFilterBank
+{
+public:
+    static constexpr int maxGrains = 8;                             // Lanes per channel, a multiple of any SIMD width
+    static constexpr int numLanes = 2 * maxGrains;
+    static constexpr float maxOctavesOfRandomness = 3.0f;           // Cutoffs spread this far either side at most
+    
+    /// Sets the sample rate, and silences every filter.
+    void prepare (double _sampleRate)
+    {
+        sampleRate = (float) _sampleRate;
+        
+        for (int grain = 0; grain < maxGrains; grain++)
+            setCoefficients (grain, MyFilter::makeLowPass (sampleRate, getMaxCutoff(), 1.0f));
+        
+        reset();
+    }
+    
+    /// Silences every filter.
+    void reset()
+    {
+        input.fill (0.0f);
+        x1.fill (0.0f);
+        x2.fill (0.0f);
+        y1.fill (0.0f);
+        y2.fill (0.0f);
+    }
+    
+    /// Seeds the random cutoffs and resonances.
+    void setRandomSeed (juce::int64 seed)
+    {
+        random.setSeed (seed);
+    }
+    
+    /**
+     Sets the filters of the grains starting from now on, once per block.
+     
+     @param _cutoffFrequency cutoff frequency, in Hz
+     @param _resonance resonnance parameter [1-20]
+     @param _randomness [0-1] how far the cutoff and resonance of each grain stray from the set ones
+     */
+    void setParameters (float _cutoffFrequency, float _resonance, float _randomness)
+    {
+        cutoffFrequency = _cutoffFrequency;
+        resonance = _resonance;
+        randomness = _randomness;
+    }
+    
+    /// Draws the filter of a grain that just started.
+    void startGrain (int grain)
+    {
+        auto octaves = (random.nextFloat() - 0.5f) * 2.0f * maxOctavesOfRandomness * randomness;
+        auto cutoff = juce::jlimit (20.0f, getMaxCutoff(), cutoffFrequency * std::exp2 (octaves));
+        auto grainResonance = resonance * (1.0f + random.nextFloat() * randomness);
+        
+        setCoefficients (grain, MyFilter::makeLowPass (sampleRate, cutoff, grainResonance));
+    }
+    
+    /// Gives a grain's samples to its filters, for the next call to process().
+    void setInput (int grain, float left, float right)
+    {
+        input[(size_t) grain] = left;
+        input[(size_t) (maxGrains + grain)] = right;
+    }
+    
+    /**
+     Steps every filter by one sample, then clears the inputs.
+     
+     @param left the filtered Left samples of every grain are added to it
+     @param right the filtered Right samples of every grain are added to it
+     */
+    void process (float& left, float& right)
+    {
+        using Register = juce::dsp::SIMDRegister<float>;
+        
+        for (size_t lane = 0; lane < (size_t) numLanes; lane += Register::SIMDNumElements)
+        {
+            auto x = Register::fromRawArray (input.data() + lane);
+            auto previousX = Register::fromRawArray (x1.data() + lane);
+            auto previousY = Register::fromRawArray (y1.data() + lane);
+            
+            auto y = Register::fromRawArray (a0.data() + lane) * x
+                   + Register::fromRawArray (a1.data() + lane) * previousX
+                   + Register::fromRawArray (a2.data() + lane) * Register::fromRawArray (x2.data() + lane)
+                   - Register::fromRawArray (b1.data() + lane) * previousY
+                   - Register::fromRawArray (b2.data() + lane) * Register::fromRawArray (y2.data() + lane);
+            
+            previousX.copyToRawArray (x2.data() + lane);
+            x.copyToRawArray (x1.data() + lane);
+            previousY.copyToRawArray (y2.data() + lane);
+            y.copyToRawArray (y1.data() + lane);
+        }
+        
+        for (int grain = 0; grain < maxGrains; grain++)
+        {
+            left += y1[(size_t) grain];
+            right += y1[(size_t) (maxGrains + grain)];
+        }
+        
+        input.fill (0.0f);
+    }
+    
+    //==========================================================================
+private:
+    using Lanes = std::array<float, numLanes>;
+    
+    // One lane per filter, aligned for the widest SIMD registers:
+    alignas (32) Lanes input {};
+    alignas (32) Lanes a0 {};
+    alignas (32) Lanes a1 {};
+    alignas (32) Lanes a2 {};
+    alignas (32) Lanes b1 {};
+    alignas (32) Lanes b2 {};
+    alignas (32) Lanes x1 {};
+    alignas (32) Lanes x2 {};
+    alignas (32) Lanes y1 {};
+    alignas (32) Lanes y2 {};
+    
+    float sampleRate = 44100.0f;
+    float cutoffFrequency = 4000.0f;
+    float resonance = 1.0f;
+    float randomness = 0.0f;
+    juce::Random random;
+    
+    /// Highest cutoff the filter design stays stable at.
+    float getMaxCutoff() const
+    {
+        return 0.45f * sampleRate;
+    }
+    
+    /// Gives both channels of a grain the same coefficients.
+    void setCoefficients (int grain, const MyFilter::Coefficients& coefficients)
+    {
+        for (auto lane : { grain, maxGrains + grain })
+        {
+            a0[(size_t) lane] = coefficients.a0;
+            a1[(size_t) lane] = coefficients.a1;
+            a2[(size_t) lane] = coefficients.a2;
+            b1[(size_t) lane] = coefficients.b1;
+            b2[(size_t) lane] = coefficients.b2;
+        }
+    }
+};
+
+
+/**
+ Low pass filter and decimator, bringing a signal down to a rate at or below a given one by an integer factor.
+ 
+ The filter is a Blackman windowed sinc of tapsPerPhase taps for every step of the factor, passing 40% of the output
+ rate, so that what folds back from above the output's Nyquist frequency lands outside of that band, more than 75 dB down.
+ As in a polyphase decimator, only the samples that are kept are worked out: tapsPerPhase multiply-adds per input sample,
+ whatever the factor.
+ 
+ process() doesn't allocate, prepare() does.
+ */
+class Decimator
+{
+public:
+    static constexpr int tapsPerPhase = 16;
+    
+    /**
+     Picks the smallest factor bringing the rate down to maxOutputRate or below, designs the filter, and clears it.
+     
+     @param _sampleRate rate of the input
+     @param maxOutputRate highest rate of the output
+     */
+    void prepare (double _sampleRate, double maxOutputRate)
+    {
+        factor = std::max (1, (int) std::ceil (_sampleRate / maxOutputRate - 1.0e-9));
+        outputRate = _sampleRate / factor;
+        numTaps = tapsPerPhase * factor;
+        
+        // Windowed sinc with its cutoff at 40% of the output rate, scaled for unity gain at DC:
+        taps.resize ((size_t) numTaps);
+        auto cutoff = 0.4 / factor;
+        auto centre = (numTaps - 1) * 0.5;
+        double sum = 0.0;
+        
+        for (int i=0; i<numTaps; i++)
+        {
+            auto x = i - centre;
+            auto sinc = x == 0.0 ? 2.0 * cutoff : std::sin (juce::MathConstants<double>::twoPi * cutoff * x) / (juce::MathConstants<double>::pi * x);
+            auto phase = juce::MathConstants<double>::twoPi * i / (numTaps - 1);
+            auto window = 0.42 - 0.5 * std::cos (phase) + 0.08 * std::cos (2.0 * phase);
+            taps[(size_t) i] = (float) (sinc * window);
+            sum += sinc * window;
+        }
+        
+        for (auto& tap : taps)
+            tap = (float) (tap / sum);
+        
+        // The delay line is written twice, so that the last numTaps samples always sit side by side:
+        history.assign ((size_t) numTaps * 2, 0.0f);
+        reset();
+    }
+    
+    /// Clears the delay line, as if silence had always come in.
+    void reset()
+    {
+        std::fill (history.begin(), history.end(), 0.0f);
+        position = 0;
+        phase = 0;
+    }
+    
+    /**
+     Takes an input sample, and works out an output sample once every factor samples.
+     
+     @param input the input sample
+     @param output receives the output sample, when there is one
+     @return true if an output sample was worked out
+     */
+    bool process (float input, float& output)
+    {
+        history[(size_t) position] = input;
+        history[(size_t) (position + numTaps)] = input;
+        position = position + 1 == numTaps ? 0 : position + 1;
+        
+        if (++phase < factor)
+            return false;
+        
+        phase = 0;
+        
+        // The taps are symmetric, so they line up with the oldest to newest samples as they are:
+        auto* samples = history.data() + position;
+        float sum = 0.0f;
+        
+        for (int i=0; i<numTaps; i++)
+            sum += taps[(size_t) i] * samples[i];
+        
+        output = sum;
+        return true;
+    }
+    
+    /// Returns the number of input samples per output sample.
+    int getFactor() const
+    {
+        return factor;
+    }
+    
+    /// Returns the rate of the output.
+    double getOutputRate() const
+    {
+        return outputRate;
+    }
+    
+    /// Returns the number of input samples it takes for the filter to ring out.
+    int getLengthInSamples() const
+    {
+        return numTaps;
+    }
+    
+    //==========================================================================
+private:
+    std::vector<float> taps;
+    std::vector<float> history;
+    double outputRate = 44100.0;
+    int factor = 1;
+    int numTaps = tapsPerPhase;
+    int position = 0;
+    int phase = 0;
+};
+
+
 /**
  Creates a Function (envelope) instance.
  Requires a sample rate, a ramp time, and a trigger.
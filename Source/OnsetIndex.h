@@ -0,0 +1,234 @@
+/*
+  ==============================================================================
+
+    OnsetIndex.h
+    Created: 18 Oct 2026 9:12:40pm
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+/**
+ Index of the onsets (transients) in a GrainBuffer, kept up to date as the buffer is written to.
+
+ The detector follows the energy envelope of the input in hops of hopSize samples, and marks an onset at the start of
+ every hop whose energy more than doubles from the hop before. FreezeAnalysis marks the onsets of a frozen buffer the
+ same way, and they are searched there once its analysis is done.
+
+ Onsets are kept in a ring, in the order they were written. Since the write position sweeps the buffer from the start
+ to the end and then wraps around, the ring always holds two sorted runs: the onsets left from the previous sweep, past
+ the write position, then those of the current sweep, up to it. Onsets are forgotten as the write position passes over
+ them, and finding the nearest onset to a position is a binary search in each run.
+
+ Every method is meant for the audio thread, and none of them allocate apart from prepare().
+ */
+class OnsetIndex
+{
+public:
+    static constexpr int hopSize = 256;
+    static constexpr float onsetRatio = 2.0f;           // Energy jump from one hop to the next marking an onset
+    static constexpr float energyFloor = 1.0e-6f;       // Mean square below which nothing counts as an onset
+
+    /**
+     Allocates room for the onsets of the largest buffer, and forgets every onset.
+
+     @param maxBufferSize maximum size of the GrainBuffer, in samples
+     */
+    void prepare (int maxBufferSize)
+    {
+        // At most one onset per hop, plus the partial hops on either side of the write position:
+        onsets.assign ((size_t) (maxBufferSize / hopSize + 4), 0);
+        reset();
+    }
+
+    /// Forgets every onset.
+    void reset()
+    {
+        oldest = 0;
+        numOnsets = 0;
+        numFromPreviousSweep = 0;
+        lastPosition = -1;
+        hopLength = 0;
+        hopEnergy = 0.0f;
+        previousHopEnergy = 0.0f;
+    }
+
+    /**
+     Follows a sample written to the buffer.
+
+     @param position position the sample was written at
+     @param left the Left sample
+     @param right the Right sample
+     */
+    void write (int position, float left, float right)
+    {
+        forgetUpTo (position);
+
+        if (hopLength == 0)
+            hopStart = position;
+
+        hopEnergy += left * left + right * right;
+
+        if (++hopLength == hopSize)
+            endHop();
+    }
+
+    /**
+     Follows silence written to the buffer, as many calls to write (position, 0.0f, 0.0f) would.
+
+     @param fromPosition position the first silent sample was written at
+     @param numSamples number of silent samples, written up to the end of the buffer at most
+     */
+    void writeSilence (int fromPosition, int numSamples)
+    {
+        if (numSamples <= 0)
+            return;
+
+        forgetUpTo (fromPosition);
+        forgetUpTo (fromPosition + numSamples - 1);
+
+        if (hopLength == 0)
+            hopStart = fromPosition;
+
+        // Finish the current hop, then skip the whole silent hops:
+        auto numToFinishHop = hopSize - hopLength;
+
+        if (numSamples < numToFinishHop)
+        {
+            hopLength += numSamples;
+            return;
+        }
+
+        endHop();
+        numSamples -= numToFinishHop;
+
+        if (numSamples >= hopSize)
+            previousHopEnergy = 0.0f;
+
+        hopLength = numSamples % hopSize;
+        hopStart = fromPosition + numToFinishHop + numSamples - hopLength;
+    }
+
+    /**
+     Finds the onset closest to a position.
+
+     @param position position to search around
+     @param maxDistance furthest the onset can be from the position, in samples
+     @param endPosition first position past the part of the buffer being read, ignoring onsets from there on
+     @return the position of the onset, or -1 if there isn't one close enough
+     */
+    int findNearest (int position, int maxDistance, int endPosition) const
+    {
+        int nearest = -1;
+        int nearestDistance = maxDistance + 1;
+
+        auto searchRun = [&] (int first, int last)
+        {
+            // First onset at or after the position, through a binary search over the sorted run [first, last):
+            auto low = first;
+            auto high = last;
+
+            while (low < high)
+            {
+                auto middle = low + (high - low) / 2;
+
+                if (getOnset (middle) < position)
+                    low = middle + 1;
+                else
+                    high = middle;
+            }
+
+            // The nearest is either it, or the one before:
+            for (auto index : { low - 1, low })
+            {
+                if (index < first || index >= last)
+                    continue;
+
+                auto onset = getOnset (index);
+                auto distance = std::abs (onset - position);
+
+                if (onset < endPosition && distance < nearestDistance)
+                {
+                    nearest = onset;
+                    nearestDistance = distance;
+                }
+            }
+        };
+
+        searchRun (0, numFromPreviousSweep);
+        searchRun (numFromPreviousSweep, numOnsets);
+
+        return nearest;
+    }
+
+    /// Returns the number of onsets currently in the buffer.
+    int getNumOnsets() const
+    {
+        return numOnsets;
+    }
+
+    //==========================================================================
+private:
+    std::vector<int> onsets;            // Ring of positions, in the order they were found
+    int oldest = 0;                     // Index in the ring of the oldest onset
+    int numOnsets = 0;
+    int numFromPreviousSweep = 0;       // Onsets, from the oldest, found before the write position last wrapped around
+    int lastPosition = -1;              // Last position written to
+
+    int hopStart = 0;
+    int hopLength = 0;
+    float hopEnergy = 0.0f;
+    float previousHopEnergy = 0.0f;
+
+    /// Returns the index-th onset, from the oldest.
+    int getOnset (int index) const
+    {
+        return onsets[(size_t) ((oldest + index) % (int) onsets.size())];
+    }
+
+    /// Forgets the onsets the write position has just passed over, and starts a new sweep when it wraps around.
+    void forgetUpTo (int position)
+    {
+        if (position < lastPosition)
+        {
+            // The onsets left from the previous sweep lie past where the buffer ended this time, so they can't be read:
+            oldest = (oldest + numFromPreviousSweep) % (int) onsets.size();
+            numOnsets -= numFromPreviousSweep;
+            numFromPreviousSweep = numOnsets;
+
+            // A hop can't carry on from the end of the buffer to its start:
+            hopLength = 0;
+            hopEnergy = 0.0f;
+        }
+
+        lastPosition = position;
+
+        while (numFromPreviousSweep > 0 && getOnset (0) <= position)
+        {
+            oldest = (oldest + 1) % (int) onsets.size();
+            numOnsets--;
+            numFromPreviousSweep--;
+        }
+    }
+
+    /// Compares the energy of the hop with the one before, adding an onset at its start if it jumped up.
+    void endHop()
+    {
+        auto energy = hopEnergy / (2.0f * hopSize);
+
+        if (energy > energyFloor && energy > onsetRatio * previousHopEnergy && numOnsets < (int) onsets.size())
+        {
+            onsets[(size_t) ((oldest + numOnsets) % (int) onsets.size())] = hopStart;
+            numOnsets++;
+        }
+
+        previousHopEnergy = energy;
+        hopLength = 0;
+        hopEnergy = 0.0f;
+    }
+};
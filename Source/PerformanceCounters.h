@@ -0,0 +1,227 @@
+/*
+  ==============================================================================
+
+    PerformanceCounters.h
+    Created: 18 Oct 2026 8:33:57pm
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+/**
+ Counters describing what the engine does, written by the audio thread and readable from any thread without locks.
+
+ The audio thread is the only writer: every counter is a relaxed atomic, updated with a plain load and store rather
+ than a locked read-modify-write. Counters only ever grow (apart from the two gauges), so readers take a Snapshot now
+ and then, and compare two of them to get rates and percentiles over the time in between:
+
+     auto now = processor.getPerformanceCounters().getSnapshot();
+     auto report = PerformanceCounters::compare (lastSnapshot, now);
+     lastSnapshot = now;
+ */
+class PerformanceCounters
+{
+public:
+
+    /// Block times are counted in bins a quarter of an octave wide, from 1 us up to about 1 s.
+    static constexpr int numBlockTimeBins = 80;
+    static constexpr int binsPerOctave = 4;
+
+    /// Cumulative counts at one point in time.
+    struct Snapshot
+    {
+        double timeInSeconds = 0.0;                 // When the snapshot was taken, from Time::getMillisecondCounterHiRes()
+        juce::int64 blocks = 0;
+        juce::int64 samples = 0;
+        juce::int64 processTicks = 0;               // Total time spent in processBlock, in high resolution ticks
+        juce::int64 analysesRun = 0;                // FFTs run on a grain
+        juce::int64 analysesSkipped = 0;            // Grains that ended without an FFT: too quiet, skipped, or analysis off
+        juce::int64 analysesLookedUp = 0;           // Grains whose analysis came from the frozen buffer's
+        juce::int64 fftTicks = 0;                   // Total time spent in processFFT, in high resolution ticks
+        juce::int64 grainsStarted = 0;
+        juce::int64 grainsSkipped = 0;              // Grains silenced by "Bourghol"
+        int activeGrains = 0;                       // Grains playing at the end of the last block
+        int activeSynthVoices = 0;                  // Synth notes playing at the end of the last block
+        std::array<juce::int64, numBlockTimeBins> blockTimeHistogram {};
+    };
+
+    /// Rates and percentiles between two snapshots.
+    struct Report
+    {
+        double seconds = 0.0;                       // Wall clock time between the snapshots
+        double blockMicrosecondsMedian = 0.0;       // Percentiles of the time spent per block, upper bounds of their bins
+        double blockMicroseconds90 = 0.0;
+        double blockMicroseconds99 = 0.0;
+        double blockMicrosecondsMax = 0.0;
+        double analysesPerSecond = 0.0;
+        double analysesSkippedPerSecond = 0.0;
+        double analysesLookedUpPerSecond = 0.0;
+        double fftMicrosecondsPerAnalysis = 0.0;
+        double fftShareOfProcessing = 0.0;          // Part of processBlock's time spent in processFFT, [0, 1]
+        double skippedGrainRate = 0.0;              // Part of the started grains skipped by "Bourghol", [0, 1]
+        int activeGrains = 0;
+        int activeSynthVoices = 0;
+    };
+
+    //==========================================================================
+    /// Audio thread: marks the start of a block.
+    void beginBlock()
+    {
+        blockStartTicks = juce::Time::getHighResolutionTicks();
+    }
+
+    /// Audio thread: marks the end of a block and records its duration.
+    void endBlock (int numSamples, int _activeGrains, int _activeSynthVoices)
+    {
+        auto ticks = juce::Time::getHighResolutionTicks() - blockStartTicks;
+        auto microseconds = juce::Time::highResolutionTicksToSeconds (ticks) * 1.0e6;
+        auto bin = microseconds < 1.0 ? 0 : juce::jmin (numBlockTimeBins - 1, (int) (binsPerOctave * std::log2 (microseconds)));
+
+        increment (blocks);
+        increment (samples, numSamples);
+        increment (processTicks, ticks);
+        increment (blockTimeHistogram[(size_t) bin]);
+        activeGrains.store (_activeGrains, std::memory_order_relaxed);
+        activeSynthVoices.store (_activeSynthVoices, std::memory_order_relaxed);
+    }
+
+    /// Audio thread: a grain ended and was analysed, taking the given time.
+    void addAnalysis (juce::int64 ticks)
+    {
+        increment (analysesRun);
+        increment (fftTicks, ticks);
+    }
+
+    /// Audio thread: a grain ended without being analysed.
+    void addSkippedAnalysis()
+    {
+        increment (analysesSkipped);
+    }
+
+    /// Audio thread: a grain ended and its analysis was looked up.
+    void addAnalysisLookup()
+    {
+        increment (analysesLookedUp);
+    }
+
+    /// Audio thread: a grain started, possibly skipped by "Bourghol".
+    void addGrainStart (bool wasSkipped)
+    {
+        increment (grainsStarted);
+
+        if (wasSkipped)
+            increment (grainsSkipped);
+    }
+
+    //==========================================================================
+    /// Any thread: reads every counter. Counters are read one by one, so they may be a block apart from each other.
+    Snapshot getSnapshot() const
+    {
+        Snapshot snapshot;
+        snapshot.timeInSeconds = juce::Time::getMillisecondCounterHiRes() * 0.001;
+        snapshot.blocks = blocks.load (std::memory_order_relaxed);
+        snapshot.samples = samples.load (std::memory_order_relaxed);
+        snapshot.processTicks = processTicks.load (std::memory_order_relaxed);
+        snapshot.analysesRun = analysesRun.load (std::memory_order_relaxed);
+        snapshot.analysesSkipped = analysesSkipped.load (std::memory_order_relaxed);
+        snapshot.analysesLookedUp = analysesLookedUp.load (std::memory_order_relaxed);
+        snapshot.fftTicks = fftTicks.load (std::memory_order_relaxed);
+        snapshot.grainsStarted = grainsStarted.load (std::memory_order_relaxed);
+        snapshot.grainsSkipped = grainsSkipped.load (std::memory_order_relaxed);
+        snapshot.activeGrains = activeGrains.load (std::memory_order_relaxed);
+        snapshot.activeSynthVoices = activeSynthVoices.load (std::memory_order_relaxed);
+
+        for (int i=0; i<numBlockTimeBins; i++)
+            snapshot.blockTimeHistogram[(size_t) i] = blockTimeHistogram[(size_t) i].load (std::memory_order_relaxed);
+
+        return snapshot;
+    }
+
+    /**
+     Works out what happened between two snapshots.
+
+     @param earlier snapshot taken first, or a default constructed one to report everything since the start
+     @param later snapshot taken last
+     */
+    static Report compare (const Snapshot& earlier, const Snapshot& later)
+    {
+        Report report;
+        report.seconds = earlier.timeInSeconds > 0.0 ? later.timeInSeconds - earlier.timeInSeconds
+                                                     : juce::Time::highResolutionTicksToSeconds (later.processTicks);
+        report.activeGrains = later.activeGrains;
+        report.activeSynthVoices = later.activeSynthVoices;
+
+        // Percentiles, from the histogram of the blocks in between:
+        std::array<juce::int64, numBlockTimeBins> histogram;
+        juce::int64 numBlocks = 0;
+
+        for (int i=0; i<numBlockTimeBins; i++)
+        {
+            histogram[(size_t) i] = later.blockTimeHistogram[(size_t) i] - earlier.blockTimeHistogram[(size_t) i];
+            numBlocks += histogram[(size_t) i];
+        }
+
+        auto percentile = [&] (double fraction)
+        {
+            juce::int64 count = 0;
+
+            for (int i=0; i<numBlockTimeBins; i++)
+            {
+                count += histogram[(size_t) i];
+
+                if (count > 0 && count >= fraction * numBlocks)
+                    return std::exp2 ((i + 1) / (double) binsPerOctave);
+            }
+
+            return 0.0;
+        };
+
+        report.blockMicrosecondsMedian = percentile (0.5);
+        report.blockMicroseconds90 = percentile (0.9);
+        report.blockMicroseconds99 = percentile (0.99);
+        report.blockMicrosecondsMax = percentile (1.0);
+
+        // Rates:
+        auto perSecond = [&] (juce::int64 difference) { return report.seconds > 0.0 ? difference / report.seconds : 0.0; };
+        auto analysesRun = later.analysesRun - earlier.analysesRun;
+        auto fftTicks = later.fftTicks - earlier.fftTicks;
+        auto processTicks = later.processTicks - earlier.processTicks;
+        auto grainsStarted = later.grainsStarted - earlier.grainsStarted;
+
+        report.analysesPerSecond = perSecond (analysesRun);
+        report.analysesSkippedPerSecond = perSecond (later.analysesSkipped - earlier.analysesSkipped);
+        report.analysesLookedUpPerSecond = perSecond (later.analysesLookedUp - earlier.analysesLookedUp);
+        report.fftMicrosecondsPerAnalysis = analysesRun > 0 ? juce::Time::highResolutionTicksToSeconds (fftTicks) * 1.0e6 / analysesRun : 0.0;
+        report.fftShareOfProcessing = processTicks > 0 ? fftTicks / (double) processTicks : 0.0;
+        report.skippedGrainRate = grainsStarted > 0 ? (later.grainsSkipped - earlier.grainsSkipped) / (double) grainsStarted : 0.0;
+
+        return report;
+    }
+
+    //==========================================================================
+private:
+    juce::int64 blockStartTicks = 0;
+
+    std::atomic<juce::int64> blocks { 0 };
+    std::atomic<juce::int64> samples { 0 };
+    std::atomic<juce::int64> processTicks { 0 };
+    std::atomic<juce::int64> analysesRun { 0 };
+    std::atomic<juce::int64> analysesSkipped { 0 };
+    std::atomic<juce::int64> analysesLookedUp { 0 };
+    std::atomic<juce::int64> fftTicks { 0 };
+    std::atomic<juce::int64> grainsStarted { 0 };
+    std::atomic<juce::int64> grainsSkipped { 0 };
+    std::atomic<int> activeGrains { 0 };
+    std::atomic<int> activeSynthVoices { 0 };
+    std::array<std::atomic<juce::int64>, numBlockTimeBins> blockTimeHistogram {};
+
+    /// Single writer, so no need for an atomic read-modify-write.
+    static void increment (std::atomic<juce::int64>& counter, juce::int64 amount = 1)
+    {
+        counter.store (counter.load (std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+};
@@ -11,15 +11,68 @@
 
 //==============================================================================
 TabboulehAudioProcessorEditor::TabboulehAudioProcessorEditor (TabboulehAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
+    : AudioProcessorEditor (&p), audioProcessor (p), grainView (p.getTelemetry())
 {
+    grainView.setQualityLevelSource ([&p] { return p.getQualityGovernor().getLevel(); });
+    grainView.setPerformanceCounters (&p.getPerformanceCounters());
+    addAndMakeVisible (grainView);
+    
+    // A control for every parameter the user can change:
+    for (auto* parameter : p.getParameters())
+    {
+        auto* rangedParameter = dynamic_cast<juce::RangedAudioParameter*> (parameter);
+        
+        if (rangedParameter == nullptr || rangedParameter->getCategory() == juce::AudioProcessorParameter::outputMeter)
+            continue;
+        
+        ParameterControl control;
+        control.label = std::make_unique<juce::Label> (juce::String(), rangedParameter->getName (64));
+        
+        if (dynamic_cast<juce::AudioParameterBool*> (rangedParameter) != nullptr)
+        {
+            auto toggle = std::make_unique<juce::ToggleButton>();
+            control.buttonAttachment = std::make_unique<juce::ButtonParameterAttachment> (*rangedParameter, *toggle);
+            control.editor = std::move (toggle);
+        }
+        else
+        {
+            auto slider = std::make_unique<juce::Slider> (juce::Slider::LinearHorizontal, juce::Slider::TextBoxRight);
+            slider->setTextBoxStyle (juce::Slider::TextBoxRight, false, 70, 20);
+            control.sliderAttachment = std::make_unique<juce::SliderParameterAttachment> (*rangedParameter, *slider);
+            control.editor = std::move (slider);
+        }
+        
+        addAndMakeVisible (*control.label);
+        addAndMakeVisible (*control.editor);
+        parameterControls.push_back (std::move (control));
+    }
+    
+    loadImpulseResponseButton.onClick = [this] { chooseImpulseResponse(); };
+    addAndMakeVisible (loadImpulseResponseButton);
+    addAndMakeVisible (impulseResponseLabel);
+    updateImpulseResponseLabel();
+    
+    loadGrainSourceButton.onClick = [this] { chooseGrainSource(); };
+    clearGrainSourceButton.onClick = [this] { audioProcessor.loadGrainSourceFile (juce::File()); updateGrainSourceLabel(); };
+    addAndMakeVisible (loadGrainSourceButton);
+    addAndMakeVisible (clearGrainSourceButton);
+    addAndMakeVisible (grainSourceLabel);
+    updateGrainSourceLabel();
+    
+    traceButton.onClick = [this] { toggleTrace(); };
+    addAndMakeVisible (traceButton);
+    addAndMakeVisible (traceLabel);
+    updateTraceLabel();
+    startTimerHz (4);
+    
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (400, 300);
+    setSize (800, 240 + (((int) parameterControls.size() + 1) / 2 + 3) * controlHeight + 10);
 }
 
 TabboulehAudioProcessorEditor::~TabboulehAudioProcessorEditor()
 {
+    stopTimer();
 }
 
 //==============================================================================
@@ -27,14 +80,149 @@ void TabboulehAudioProcessorEditor::paint (juce::Graphics& g)
 {
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
-
-    g.setColour (juce::Colours::white);
-    g.setFont (15.0f);
-    g.drawFittedText ("Hello World!", getLocalBounds(), juce::Justification::centred, 1);
 }
 
 void TabboulehAudioProcessorEditor::resized()
 {
-    // This is generally where you'll want to lay out the positions of any
-    // subcomponents in your editor..
+    auto bounds = getLocalBounds();
+    grainView.setBounds (bounds.removeFromTop (240));
+    
+    // Controls in two columns, label on the left:
+    bounds.reduce (10, 5);
+    int rowsPerColumn = ((int) parameterControls.size() + 1) / 2;
+    auto columnWidth = bounds.getWidth() / 2;
+    
+    for (int i=0; i<(int) parameterControls.size(); i++)
+    {
+        auto row = juce::Rectangle<int> (bounds.getX() + (i / rowsPerColumn) * columnWidth,
+                                         bounds.getY() + (i % rowsPerColumn) * controlHeight,
+                                         columnWidth - 10, controlHeight);
+        
+        parameterControls[(size_t) i].label->setBounds (row.removeFromLeft (130));
+        parameterControls[(size_t) i].editor->setBounds (row);
+    }
+    
+    auto impulseResponseRow = bounds.withTrimmedTop (rowsPerColumn * controlHeight).withHeight (controlHeight);
+    loadImpulseResponseButton.setBounds (impulseResponseRow.removeFromLeft (200).reduced (0, 2));
+    impulseResponseLabel.setBounds (impulseResponseRow.withTrimmedLeft (10));
+    
+    auto grainSourceRow = impulseResponseRow.withY (impulseResponseRow.getBottom()).withX (bounds.getX()).withWidth (bounds.getWidth());
+    loadGrainSourceButton.setBounds (grainSourceRow.removeFromLeft (200).reduced (0, 2));
+    clearGrainSourceButton.setBounds (grainSourceRow.removeFromLeft (70).reduced (5, 2));
+    grainSourceLabel.setBounds (grainSourceRow.withTrimmedLeft (5));
+    
+    auto traceRow = impulseResponseRow.withY (impulseResponseRow.getBottom() + controlHeight).withX (bounds.getX()).withWidth (bounds.getWidth());
+    traceButton.setBounds (traceRow.removeFromLeft (200).reduced (0, 2));
+    traceLabel.setBounds (traceRow.withTrimmedLeft (10));
+}
+
+//==============================================================================
+void TabboulehAudioProcessorEditor::chooseImpulseResponse()
+{
+    fileChooser = std::make_unique<juce::FileChooser> ("Impulse response for Extra Virgin", audioProcessor.getImpulseResponseFile(), "*.wav;*.aif;*.aiff;*.flac");
+    
+    auto flags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles;
+    
+    fileChooser->launchAsync (flags, [this] (const juce::FileChooser& chooser)
+    {
+        auto file = chooser.getResult();
+        
+        if (file == juce::File())
+            return;
+        
+        if (! audioProcessor.loadImpulseResponse (file))
+            juce::AlertWindow::showMessageBoxAsync (juce::MessageBoxIconType::WarningIcon, "Extra Virgin", "Could not read " + file.getFullPathName());
+        
+        updateImpulseResponseLabel();
+    });
+}
+
+void TabboulehAudioProcessorEditor::chooseGrainSource()
+{
+    fileChooser = std::make_unique<juce::FileChooser> ("Audio file for Pantry", audioProcessor.getGrainSourceFile(), "*.wav;*.aif;*.aiff;*.flac;*.ogg");
+    
+    auto flags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles;
+    
+    // Loading happens in the background, the timer follows it:
+    fileChooser->launchAsync (flags, [this] (const juce::FileChooser& chooser)
+    {
+        auto file = chooser.getResult();
+        
+        if (file != juce::File())
+            audioProcessor.loadGrainSourceFile (file);
+        
+        updateGrainSourceLabel();
+    });
+}
+
+void TabboulehAudioProcessorEditor::updateGrainSourceLabel()
+{
+    auto file = audioProcessor.getGrainSourceFile();
+    juce::String text;
+    
+    switch (audioProcessor.getGrainSourceStatus())
+    {
+        case FileGrainSource::Status::empty:    text = "No pantry file, grains only read the input"; break;
+        case FileGrainSource::Status::loading:  text = "Loading " + file.getFileName() + "..."; break;
+        case FileGrainSource::Status::ready:    text = file.getFileName(); break;
+        case FileGrainSource::Status::failed:   text = "Could not read " + file.getFileName(); break;
+    }
+    
+    if (grainSourceLabel.getText() != text)
+        grainSourceLabel.setText (text, juce::dontSendNotification);
+}
+
+void TabboulehAudioProcessorEditor::toggleTrace()
+{
+    auto& recorder = audioProcessor.getTraceRecorder();
+    
+    if (recorder.isRecording())
+    {
+        recorder.stop();
+    }
+    else
+    {
+        auto folder = juce::File::getSpecialLocation (juce::File::userDocumentsDirectory).getChildFile ("Tabbouleh Traces");
+        auto file = folder.getNonexistentChildFile ("trace " + juce::Time::getCurrentTime().formatted ("%Y-%m-%d %H-%M-%S"), ".json", false);
+        
+        if (! folder.createDirectory() || ! recorder.start (file))
+            juce::AlertWindow::showMessageBoxAsync (juce::MessageBoxIconType::WarningIcon, "Trace", "Could not create " + file.getFullPathName());
+    }
+    
+    updateTraceLabel();
+}
+
+void TabboulehAudioProcessorEditor::updateTraceLabel()
+{
+    auto& recorder = audioProcessor.getTraceRecorder();
+    auto file = recorder.getFile();
+    juce::String text;
+    
+    if (recorder.isRecording())
+        text = "Recording " + file.getFileName();
+    else if (file != juce::File())
+        text = "Trace written to " + file.getFullPathName();
+    else
+        text = "No trace, records a timeline of processBlock for ui.perfetto.dev";
+    
+    if (recorder.getNumDropped() > 0)
+        text += " (" + juce::String (recorder.getNumDropped()) + " events dropped)";
+    
+    traceButton.setButtonText (recorder.isRecording() ? "Stop trace" : "Record trace");
+    
+    if (traceLabel.getText() != text)
+        traceLabel.setText (text, juce::dontSendNotification);
+}
+
+void TabboulehAudioProcessorEditor::timerCallback()
+{
+    updateGrainSourceLabel();
+    updateTraceLabel();
+}
+
+void TabboulehAudioProcessorEditor::updateImpulseResponseLabel()
+{
+    auto file = audioProcessor.getImpulseResponseFile();
+    impulseResponseLabel.setText (file == juce::File() ? "No impulse response, Oil uses the algorithmic reverb"
+                                                       : file.getFileName(), juce::dontSendNotification);
 }
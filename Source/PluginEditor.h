@@ -10,11 +10,14 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "GrainView.h"
 
 //==============================================================================
 /**
+ Editor showing the GrainView above a control for each of the processor's parameters.
 */
-class TabboulehAudioProcessorEditor  : public juce::AudioProcessorEditor
+class TabboulehAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                       private juce::Timer
 {
 public:
     TabboulehAudioProcessorEditor (TabboulehAudioProcessor&);
@@ -28,6 +31,55 @@ private:
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     TabboulehAudioProcessor& audioProcessor;
+    
+    GrainView grainView;
+    
+    /// A parameter's label, with a slider or a toggle attached to it.
+    struct ParameterControl
+    {
+        std::unique_ptr<juce::Label> label;
+        std::unique_ptr<juce::Component> editor;
+        std::unique_ptr<juce::SliderParameterAttachment> sliderAttachment;
+        std::unique_ptr<juce::ButtonParameterAttachment> buttonAttachment;
+    };
+    
+    std::vector<ParameterControl> parameterControls;
+    static constexpr int controlHeight = 28;
+    
+    // Impulse response for "Extra Virgin", below the parameters:
+    juce::TextButton loadImpulseResponseButton { "Load impulse response..." };
+    juce::Label impulseResponseLabel;
+    std::unique_ptr<juce::FileChooser> fileChooser;
+    
+    /// Lets the user pick an impulse response file, and loads it into the processor.
+    void chooseImpulseResponse();
+    
+    /// Shows the name of the impulse response in use.
+    void updateImpulseResponseLabel();
+    
+    // Audio file for "Pantry", below the impulse response:
+    juce::TextButton loadGrainSourceButton { "Load pantry file..." };
+    juce::TextButton clearGrainSourceButton { "Clear" };
+    juce::Label grainSourceLabel;
+    
+    /// Lets the user pick an audio file for the grains to read from, and starts loading it.
+    void chooseGrainSource();
+    
+    /// Shows the name of the grain source file, and whether it is still loading.
+    void updateGrainSourceLabel();
+    
+    // Timeline of processBlock, below the pantry file:
+    juce::TextButton traceButton { "Record trace" };
+    juce::Label traceLabel;
+    
+    /// Starts recording a trace into a new file of the documents folder, or stops the one recording.
+    void toggleTrace();
+    
+    /// Shows the trace file, and whether it is still being recorded.
+    void updateTraceLabel();
+    
+    /// Follows the grain source file while it loads in the background, and the trace while it records.
+    void timerCallback() override;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TabboulehAudioProcessorEditor)
 };
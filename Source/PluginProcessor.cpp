@@ -8,6 +8,11 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "BinaryState.h"
+
+#if TABBOULEH_REALTIME_CHECKS
+ #include "RealtimeChecker.h"
+#endif
 
 
 //==============================================================================
@@ -40,7 +45,28 @@ parameters(*this, nullptr, "ParameterTree", {
     std::make_unique<juce::AudioParameterFloat>("frequency_Precision" ,"Mint", 0.0f, 1.0f, 0.6f),
     std::make_unique<juce::AudioParameterFloat>("highPass_Frequency" ,"Lemon", juce::NormalisableRange<float>(20.0f, 2500.0f, 1.0f, 0.3), 100.0f),
     std::make_unique<juce::AudioParameterFloat>("reverb_Amount" ,"Oil", 0.0f, 0.99f, 0.4f),
-    std::make_unique<juce::AudioParameterFloat>("freqA" ,"Tuning: A = (Hz)", 400.0f, 500.0f, 440.0f)
+    std::make_unique<juce::AudioParameterFloat>("freqA" ,"Tuning: A = (Hz)", 400.0f, 500.0f, 440.0f),
+    std::make_unique<juce::AudioParameterBool>("freeze" ,"Leftovers", false),
+    std::make_unique<juce::AudioParameterBool>("onset_Snap" ,"Salt", false),
+    std::make_unique<juce::AudioParameterBool>("grain_Spectral" ,"Blender", false),
+    std::make_unique<juce::AudioParameterFloat>("spectral_Stretch" ,"Resting Time", 0.0f, 1.0f, 0.0f),
+    std::make_unique<juce::AudioParameterFloat>("spectral_Smear" ,"Stirring", 0.0f, 1.0f, 0.0f),
+    std::make_unique<juce::AudioParameterBool>("grain_Filter" ,"Cucumber", false),
+    std::make_unique<juce::AudioParameterFloat>("grain_FilterCutoff" ,"Cucumber Size", juce::NormalisableRange<float>(100.0f, 16000.0f, 1.0f, 0.3), 4000.0f),
+    std::make_unique<juce::AudioParameterFloat>("grain_FilterResonance" ,"Cucumber Crunch", 1.0f, 10.0f, 2.0f),
+    std::make_unique<juce::AudioParameterFloat>("grain_FilterRandomness" ,"Pepper", 0.0f, 1.0f, 0.5f),
+    std::make_unique<juce::AudioParameterFloat>("source_Chance" ,"Pantry", 0.0f, 1.0f, 0.0f),
+    std::make_unique<juce::AudioParameterFloat>("source_Position" ,"Pantry Shelf", 0.0f, 1.0f, 0.0f),
+    
+    // Read only, level of the QualityGovernor (0 is full quality):
+    std::make_unique<juce::AudioParameterFloat>("quality_Level" ,"Chef's Shortcuts", juce::NormalisableRange<float>(0.0f, float (QualityGovernor::numLevels - 1), 1.0f), 0.0f,
+                                                "", juce::AudioProcessorParameter::outputMeter),
+    
+    // Later parameters go at the end, so that hosts addressing parameters by index keep their automation:
+    std::make_unique<juce::AudioParameterBool>("reverb_Convolution" ,"Extra Virgin", false),
+    std::make_unique<juce::AudioParameterBool>("reverb_Lush" ,"Cold Pressed", false),
+    std::make_unique<juce::AudioParameterFloat>("synth_BandLow" ,"Tomato Roots", juce::NormalisableRange<float>(20.0f, 1000.0f, 1.0f, 0.4), 60.0f),
+    std::make_unique<juce::AudioParameterFloat>("synth_BandHigh" ,"Tomato Leaves", juce::NormalisableRange<float>(500.0f, 7000.0f, 1.0f, 0.4), 5000.0f)
     
     
 })
@@ -58,14 +84,32 @@ parameters(*this, nullptr, "ParameterTree", {
     synthOscillatorSelectParam = parameters.getRawParameterValue("synth_oscSelect");
     synthEnvelopeShapeParam = parameters.getRawParameterValue("synth_Envelope");
     synthVolumeThresholdParam = parameters.getRawParameterValue("synth_Volume_Threshold");
+    synthBandLowParam = parameters.getRawParameterValue("synth_BandLow");
+    synthBandHighParam = parameters.getRawParameterValue("synth_BandHigh");
     frequencyPrecisionParam = parameters.getRawParameterValue("frequency_Precision");
     hpFrequencyParam = parameters.getRawParameterValue("highPass_Frequency");
     reverbAmountParam = parameters.getRawParameterValue("reverb_Amount");
+    convolutionParam = parameters.getRawParameterValue("reverb_Convolution");
+    reverbLushParam = parameters.getRawParameterValue("reverb_Lush");
     freqAParam = parameters.getRawParameterValue("freqA");
+    freezeParam = parameters.getRawParameterValue("freeze");
+    onsetSnapParam = parameters.getRawParameterValue("onset_Snap");
+    spectralModeParam = parameters.getRawParameterValue("grain_Spectral");
+    spectralStretchParam = parameters.getRawParameterValue("spectral_Stretch");
+    spectralSmearParam = parameters.getRawParameterValue("spectral_Smear");
+    grainFilterParam = parameters.getRawParameterValue("grain_Filter");
+    grainFilterCutoffParam = parameters.getRawParameterValue("grain_FilterCutoff");
+    grainFilterResonanceParam = parameters.getRawParameterValue("grain_FilterResonance");
+    grainFilterRandomnessParam = parameters.getRawParameterValue("grain_FilterRandomness");
+    sourceChanceParam = parameters.getRawParameterValue("source_Chance");
+    sourcePositionParam = parameters.getRawParameterValue("source_Position");
+    qualityLevelParam = parameters.getParameter("quality_Level");
 }
 
 TabboulehAudioProcessor::~TabboulehAudioProcessor()
 {
+    stopTimer();
+    freezeAnalysis.stop (*analysisThread);
 }
 
 //==============================================================================
@@ -74,9 +118,15 @@ void TabboulehAudioProcessor::prepareToPlay (double _sampleRate, int samplesPerB
     // Store sampleRate for later use:
     sampleRate = _sampleRate;
     
-    // Initialise the Grain Buffer instance:
-    grainBuffer.initialise (maxDelaySizeInSeconds, _sampleRate);
+    // Initialise the Grain Buffer instance, once no analysis is reading it:
+    freezeAnalysis.stop (*analysisThread);
+    grainBuffer.initialise (maxDelaySizeInSeconds, _sampleRate, historyStorage);
     grainBuffer.setBufferSize (*bufferSizeParam);
+    grainBuffer.setFrozen (false);
+    freezeAnalysis.prepare (sampleRate, (int) maxDelaySizeInSeconds * sampleRate);
+    spectralGrains.prepare ((int) maxDelaySizeInSeconds * sampleRate);
+    grainFilters.prepare (sampleRate);
+    fileSource.prepare (sampleRate);
 
     // Initialise the grain manager:
     grainManager.managePhases(*activeGrainsParam);
@@ -93,20 +143,68 @@ void TabboulehAudioProcessor::prepareToPlay (double _sampleRate, int samplesPerB
         {
             if (fftsynths.size() < maxFftSynthCount)
                 fftsynths.push_back(FFTSynth(_sampleRate, 0.5f, *grainLengthParam, *frequencyPrecisionParam, *freqAParam));
+            
+            fftsynths[i].setPerformanceCounters (&performanceCounters);
+            fftsynths[i].setTraceRecorder (&traceRecorder, i);
+        }
+    
+    // Replay the same random choices from here on, if asked to:
+    if (hasRandomSeed)
+    {
+        for (int i=0; i<maxGrainCount; i++)
+        {
+            grains[i].setRandomSeed (randomSeed + i);
+            fftsynths[i].setRandomSeed (randomSeed + maxGrainCount + i);
         }
+        
+        spectralGrains.setRandomSeed (randomSeed + 2 * maxGrainCount);
+        grainFilters.setRandomSeed (randomSeed + 2 * maxGrainCount + 1);
+        sourceRandom.setSeed (randomSeed + 2 * maxGrainCount + 2);
+    }
     
     // Initialise the filters and reverb:
     hpFilterL.setCoefficients(juce::IIRCoefficients::makeHighPass(sampleRate, *hpFrequencyParam));
     hpFilterR.setCoefficients(juce::IIRCoefficients::makeHighPass(sampleRate, *hpFrequencyParam));
+    hpFrequency = *hpFrequencyParam;
     
+    // The network is picked by "Cold Pressed" alone, so that a bounce sounds the same as what was monitored:
+    reverb.setQuality (*reverbLushParam > 0.5f ? FDNReverb::Quality::lush : FDNReverb::Quality::economy);
+    reverb.prepare (sampleRate);
     setReverbParams(reverbParams, *reverbAmountParam, *grainStereoRandomnessParam);
-    reverb.setSampleRate(sampleRate);
     reverb.setParameters(reverbParams);
+    convolutionReverb.prepare (sampleRate);
+    convolutionReverb.setParameters(reverbParams);
+    reverbReturn.setSize (2, juce::jmax (1, samplesPerBlock));
+    
+    // Start awake:
+    samplesSinceSound = 0;
+    isIdle = false;
+    
+    // Offline renders have all the time they need, only govern realtime playback:
+    qualityGovernor.prepare (sampleRate);
+    qualityGovernor.setEnabled (! isNonRealtime());
+    
+    if (isNonRealtime())
+        stopTimer();
+    else
+        startTimerHz (10);
     
 }
 
 void TabboulehAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+   #if TABBOULEH_REALTIME_CHECKS
+    // Flags any allocation, lock or blocking call made from here on:
+    RealtimeChecker::ScopedRealtimeSection realtimeSection;
+   #endif
+
+    qualityGovernor.beginBlock();
+    performanceCounters.beginBlock();
+    
+    // Only time what happens when a trace is recording:
+    bool recordTrace = traceRecorder.isRecording();
+    auto blockStartTicks = recordTrace ? TraceRecorder::now() : 0;
+
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -120,13 +218,54 @@ void TabboulehAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, ju
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    // Get read pointers:
-    auto* inputLeftChannelData = buffer.getReadPointer(0);
-    auto* inputRightChannelData = buffer.getReadPointer(1);
+    // Once the input has been silent for longer than every tail, the grains can only play back silence:
+    // skip the whole engine and just keep filling the buffer with silence.
+    float inputLevel = 0.0f;
     
-    // Get write pointers:
-    auto* outputLeftChannelData = buffer.getWritePointer(0);
-    auto* outputRightChannelData = buffer.getWritePointer(1);
+    for (int channel = 0; channel < totalNumInputChannels; channel++)
+        inputLevel = std::max (inputLevel, buffer.getMagnitude (channel, 0, buffer.getNumSamples()));
+    
+    if (inputLevel > silenceThreshold)
+        samplesSinceSound = 0;
+    else
+        samplesSinceSound += buffer.getNumSamples();
+    
+    // Grains reading from a file play whatever the input does:
+    fileGrainChance = fileSource.update() ? (float) *sourceChanceParam : 0.0f;
+    
+    bool wasIdle = isIdle;
+    isIdle = ! grainBuffer.isFrozen() && fileGrainChance == 0.0f && (double) samplesSinceSound > getTailLengthSeconds() * sampleRate;
+    
+    if (isIdle)
+    {
+        // Drop whatever is left below the threshold, to start again from a clean state:
+        if (! wasIdle)
+        {
+            reverb.reset();
+            convolutionReverb.reset();
+            hpFilterL.reset();
+            hpFilterR.reset();
+            spectralGrains.reset();         // Its frames would outlive the silence written into the buffer
+            grainFilters.reset();
+        }
+        
+        grainBuffer.setBufferSize (*bufferSizeParam);
+        grainBuffer.writeSilence (buffer.getNumSamples());
+        
+        for (auto channel = 0; channel < totalNumOutputChannels; channel++)
+            buffer.clear (channel, 0, buffer.getNumSamples());
+        
+        if (telemetry.isActive())
+            telemetry.push ({ TelemetryEvent::bufferWritten, 0, grainBuffer.getWritePos(), 0.0f, grainBuffer.getMaxReadPos() });
+        
+        qualityGovernor.endBlock (buffer.getNumSamples());
+        performanceCounters.endBlock (buffer.getNumSamples(), 0, 0);
+        
+        if (recordTrace)
+            traceRecorder.addSpan (TraceEvent::idleBlock, blockStartTicks, 0, (float) buffer.getNumSamples());
+        
+        return;
+    }
     
     // Check if activeGrainsParam (Onion) changed:
     if (*activeGrainsParam != activeGrains)
@@ -140,32 +279,299 @@ void TabboulehAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, ju
 
     }
     
-    // Set the tuning precision to the FFTSynths:
+    // Freeze or unfreeze the buffer. A frozen buffer is analysed once, in the background, and written to again only
+    // once that analysis has stopped reading it:
+    if (*freezeParam > 0.5f && ! grainBuffer.isFrozen())
+    {
+        grainBuffer.setFrozen (true);
+        freezeAnalysis.request ({ *synthBandLowParam, *synthBandHighParam });
+    }
+    else if (*freezeParam <= 0.5f && grainBuffer.isFrozen() && freezeAnalysis.release())
+    {
+        grainBuffer.setFrozen (false);
+    }
+    
+    // Offline, there is no need for a background thread:
+    if (isNonRealtime())
+        freezeAnalysis.analyseIfRequested();
+    
+    bool useFreezeAnalysis = grainBuffer.isFrozen() && freezeAnalysis.isReady();
+    
+    // File grains read from a window of the file as long as the buffer, placed by "Pantry Shelf". The prefetcher
+    // keeps that window in memory:
+    if (fileGrainChance > 0.0f)
+    {
+        auto windowLength = (int) grainBuffer.getMaxReadPos();
+        fileWindowStart = (juce::int64) (*sourcePositionParam * (float) std::max ((juce::int64) 0, fileSource.getNumFrames() - windowLength));
+        fileSource.setRegion (fileWindowStart, windowLength);
+        fileSource.setNonRealtime (isNonRealtime());
+    }
+    
+    // Set the tuning precision and the band listenned to to the FFTSynths, and how much analysis the CPU load allows:
+    int numAnalysisVoices = qualityGovernor.getNumAnalysisVoices (maxFftSynthCount);
+    
     for (int i=0; i<maxGrainCount; i++)
+    {
         fftsynths[i].setPrecision (*frequencyPrecisionParam, *freqAParam);
+        fftsynths[i].setAnalysisBand (*synthBandLowParam, *synthBandHighParam);
+        fftsynths[i].setAnalysisEnabled (i < numAnalysisVoices);
+        fftsynths[i].setSmallerFFT (qualityGovernor.useSmallerFFT());
+    }
     
+    // Number of grains the CPU load allows:
+    int numGrains = qualityGovernor.getNumGrains (maxGrainCount);
     
-    // Recalibrate the High Pass Filters to user setting:
-    hpFilterL.setCoefficients(juce::IIRCoefficients::makeHighPass(sampleRate, *hpFrequencyParam));
-    hpFilterR.setCoefficients(juce::IIRCoefficients::makeHighPass(sampleRate, *hpFrequencyParam));
+    // Only tell the editor what happens when it is open:
+    bool publishTelemetry = telemetry.isActive();
+    
+    
+    // Update Reverb Parameters, once per block:
+    setReverbParams(reverbParams, *reverbAmountParam, *grainStereoRandomnessParam);
+    reverb.setParameters(reverbParams);
+    convolutionReverb.setParameters(reverbParams);
+    
+    // "Cold Pressed" switches to the denser, modulated network, starting it again from silence:
+    auto reverbQuality = *reverbLushParam > 0.5f ? FDNReverb::Quality::lush : FDNReverb::Quality::economy;
+    
+    if (reverbQuality != reverb.getQuality())
+        reverb.setQuality (reverbQuality);
+    
+    // "Oil" at 0 only lets the dry signal through, without running either reverb, once the wet gain has ramped down:
+    bool reverbWasBypassed = reverbBypassed;
+    reverbBypassed = reverbParams.wetLevel <= 0.0f && ! (usedConvolution ? convolutionReverb.isWetRamping() : reverb.isWetRamping());
+    
+    // Convolve when asked to and an impulse response is loaded, starting whichever reverb takes over from silence, or
+    // comes back once "Oil" is up again:
+    bool useConvolution = convolutionReverb.update() && *convolutionParam > 0.5f;
+    
+    if (useConvolution != usedConvolution || (reverbWasBypassed && ! reverbBypassed))
+    {
+        usedConvolution = useConvolution;
+        
+        if (useConvolution)
+            convolutionReverb.reset();
+        else
+            reverb.reset();
+    }
+    
+    // Recalibrate the High Pass Filters to user setting, when it changed. The filters always run, as what they write
+    // into the buffer is what the grains play once heard again:
+    if (*hpFrequencyParam != hpFrequency)
+    {
+        hpFrequency = *hpFrequencyParam;
+        hpFilterL.setCoefficients(juce::IIRCoefficients::makeHighPass(sampleRate, hpFrequency));
+        hpFilterR.setCoefficients(juce::IIRCoefficients::makeHighPass(sampleRate, hpFrequency));
+    }
+    
+    // Grains at "Parsley Amount" 0 and synths at "Tomato Amount" 0 can't be heard, and are skipped in the render loop.
+    // The synths stop their notes, and listen again from the next grain once heard again:
+    bool synthsWereBypassed = synthsBypassed;
+    synthsBypassed = *synthVolumeParam <= 0.0f;
+    
+    if (synthsBypassed && ! synthsWereBypassed)
+        for (auto& synth : fftsynths)
+            synth.stop();
+    
+    // The grains keep walking through the buffer, only their filters start again from silence:
+    if (grainsBypassed && *grainVolumeParam > 0.0f)
+        grainFilters.reset();
+    
+    grainsBypassed = *grainVolumeParam <= 0.0f;
+    
+    // "Blender" only analyses the buffer while on. Turned on, it starts again from empty frames, which fill as the
+    // buffer is written, or from the buffer held by "Leftovers" a few hops per block. Grains reading frames not yet
+    // analysed play silence:
+    bool spectralWasOn = spectralOn;
+    spectralOn = *spectralModeParam > 0.5f;
+    
+    if (spectralOn && ! spectralWasOn)
+    {
+        spectralGrains.reset();
+        spectralCatchUpPosition = grainBuffer.isFrozen() ? 0 : -1;
+    }
+    
+    if (spectralOn && spectralCatchUpPosition >= 0)
+    {
+        auto end = std::min (spectralCatchUpPosition + spectralCatchUpPerBlock, (int) grainBuffer.getMaxReadPos());
+        
+        // Once released, the buffer is analysed as it is written again:
+        if (! grainBuffer.isFrozen())
+            end = spectralCatchUpPosition;
+        
+        for (; spectralCatchUpPosition < end; spectralCatchUpPosition++)
+            spectralGrains.write (spectralCatchUpPosition, grainBuffer.readValL (spectralCatchUpPosition), grainBuffer.readValR (spectralCatchUpPosition));
+        
+        if (! grainBuffer.isFrozen() || spectralCatchUpPosition >= (int) grainBuffer.getMaxReadPos())
+            spectralCatchUpPosition = -1;
+    }
+    
+    // Pick the render loop compiled for the grains to play, the channels and the oscillators heard. Grains past Onion
+    // are silent, so only those up to it are played, along with any further synth still finishing its note:
+    int numVoices = std::min (numGrains, (int) std::ceil (*activeGrainsParam));
+    
+    for (int i=numVoices; i<numGrains; i++)
+        if (fftsynths[i].isPlaying())
+            numVoices = i + 1;
+    
+    auto numChannels = std::min (totalNumOutputChannels, 2);
+    auto variant = getRenderVariant (numVoices, numChannels, getOscillatorSet (*synthOscillatorSelectParam));
+    
+    if (variant != renderVariant)
+    {
+        renderVariant = variant;
+        renderFunction = renderFunctions[(size_t) variant];
+    }
+    
+    (this->*renderFunction) (buffer, useFreezeAnalysis, publishTelemetry, recordTrace);
+    
+    // Tell the editor where the grains, synths and buffer are at the end of the block:
+    if (publishTelemetry)
+    {
+        for (int i=0; i<maxGrainCount; i++)
+        {
+            auto grainEnvelope = i < numVoices ? grains[i].getSampleEnvelope() * grainManager.getVolumeForGrain(i) : 0.0f;
+            telemetry.push ({ TelemetryEvent::grainState, (juce::uint8) i, (int) grains[i].getReadPos(), grainEnvelope });
+            telemetry.push ({ TelemetryEvent::synthState, (juce::uint8) i, 0, fftsynths[i].getEnvelopeLevel() });
+        }
+        
+        // A frozen buffer isn't written to:
+        if (! grainBuffer.isFrozen())
+            telemetry.push ({ TelemetryEvent::bufferWritten, 0, grainBuffer.getWritePos(), inputLevel, grainBuffer.getMaxReadPos() });
+    }
+    
+    // Apply reverb through its send path, in chunks as long as the return buffer. In mono, the one channel is sent to
+    // both sides of the reverb, and both sides are mixed back into it:
+    auto* outputLeftChannelData = buffer.getWritePointer (0);
+    auto* outputRightChannelData = buffer.getWritePointer (numChannels - 1);
+    
+    if (reverbBypassed)
+    {
+        if (useConvolution)
+            convolutionReverb.applyDryGain (outputLeftChannelData, outputRightChannelData, buffer.getNumSamples());
+        else
+            reverb.applyDryGain (outputLeftChannelData, outputRightChannelData, buffer.getNumSamples());
+    }
+    else
+    {
+        auto reverbStartTicks = recordTrace ? TraceRecorder::now() : 0;
+        
+        for (int start = 0; start < buffer.getNumSamples(); start += reverbReturn.getNumSamples())
+        {
+            int numSamples = std::min (reverbReturn.getNumSamples(), buffer.getNumSamples() - start);
+            auto* returnLeft = reverbReturn.getWritePointer (0);
+            auto* returnRight = reverbReturn.getWritePointer (1);
+        
+            if (useConvolution)
+                convolutionReverb.processSend (outputLeftChannelData + start, outputRightChannelData + start, returnLeft, returnRight, numSamples);
+            else
+                reverb.processSend (outputLeftChannelData + start, outputRightChannelData + start, returnLeft, returnRight, numSamples);
+        
+            // The same pointer twice in mono, scaled once:
+            if (useConvolution)
+                convolutionReverb.applyDryGain (outputLeftChannelData + start, outputRightChannelData + start, numSamples);
+            else
+                reverb.applyDryGain (outputLeftChannelData + start, outputRightChannelData + start, numSamples);
+        
+            if (numChannels == 1)
+            {
+                juce::FloatVectorOperations::addWithMultiply (outputLeftChannelData + start, returnLeft, 0.5f, numSamples);
+                juce::FloatVectorOperations::addWithMultiply (outputLeftChannelData + start, returnRight, 0.5f, numSamples);
+            }
+            else
+            {
+                juce::FloatVectorOperations::add (outputLeftChannelData + start, returnLeft, numSamples);
+                juce::FloatVectorOperations::add (outputRightChannelData + start, returnRight, numSamples);
+            }
+        }
+        
+        if (recordTrace)
+            traceRecorder.addSpan (TraceEvent::reverb, reverbStartTicks, 0, useConvolution ? 1.0f : 0.0f);
+    }
+    
+    qualityGovernor.endBlock (buffer.getNumSamples());
+    
+    // Grains and synth notes playing at the end of the block:
+    int numActiveGrains = 0;
+    int numActiveSynthVoices = 0;
+    
+    for (int i=0; i<maxGrainCount; i++)
+    {
+        if (i < numVoices && grainManager.getVolumeForGrain(i) > 0.0f && ! grains[i].isSkipped())
+            numActiveGrains++;
+        
+        if (fftsynths[i].isPlaying())
+            numActiveSynthVoices++;
+    }
+    
+    performanceCounters.endBlock (buffer.getNumSamples(), numActiveGrains, numActiveSynthVoices);
+    
+    if (recordTrace)
+        traceRecorder.addSpan (TraceEvent::block, blockStartTicks, 0, (float) buffer.getNumSamples());
+}
+
+/**
+ The per sample render loop, compiled for every combination of its configuration so that the grain loop has a fixed
+ count, mono skips the right channel altogether, and the silent oscillators are never processed.
+ 
+ @tparam numVoices number of grains and synths to play
+ @tparam numChannels 1 for mono, 2 for stereo
+ @tparam oscillators oscillators heard at the current oscillator select value
+ */
+template <int numVoices, int numChannels, OscillatorSet oscillators>
+void TabboulehAudioProcessor::renderVoices (juce::AudioBuffer<float>& buffer, bool useFreezeAnalysis, bool publishTelemetry, bool recordTrace)
+{
+    // Get read pointers:
+    auto* inputLeftChannelData = buffer.getReadPointer(0);
+    auto* inputRightChannelData = buffer.getReadPointer(numChannels - 1);
+    
+    // Get write pointers:
+    auto* outputLeftChannelData = buffer.getWritePointer(0);
+    auto* outputRightChannelData = buffer.getWritePointer(numChannels - 1);
+    
+    // New grains can start on the nearest onset within a grain length of where they would have started:
+    bool snapToOnsets = *onsetSnapParam > 0.5f;
+    int maxSnapDistance = (int) (*grainLengthParam * sampleRate);
+    
+    // Spectral grains play the frames of the buffer's STFT in place of its samples:
+    bool spectralMode = spectralOn;
+    
+    if (spectralMode)
+    {
+        spectralGrains.setParameters (1.0f - *spectralStretchParam, *spectralSmearParam, (int) grainBuffer.getMaxReadPos());
+        
+        for (int i=numVoices; i<maxGrainCount; i++)
+            spectralGrains.setGain (i, 0.0f, 0.0f);
+    }
+    
+    // Each time domain grain can go through its own low pass, drawn when it starts:
+    bool filterGrains = *grainFilterParam > 0.5f && ! spectralMode && ! grainsBypassed;
+    
+    // The buffer is only read for grains that are heard, or for synths listenning to them:
+    bool readGrains = ! grainsBypassed || (! synthsBypassed && ! useFreezeAnalysis);
+    
+    if (filterGrains)
+        grainFilters.setParameters (*grainFilterCutoffParam, *grainFilterResonanceParam, *grainFilterRandomnessParam);
     
-    //DSP Loop
     for (int DSPiterator = 0; DSPiterator < buffer.getNumSamples(); DSPiterator++)
     {
         // Get the filtered incoming audio samples for both L and R channels:
         float inputSampleLeft = hpFilterL.processSingleSampleRaw(inputLeftChannelData[DSPiterator]);
-        float inputSampleRight = hpFilterR.processSingleSampleRaw(inputRightChannelData[DSPiterator]);
+        float inputSampleRight = numChannels == 1 ? inputSampleLeft : hpFilterR.processSingleSampleRaw(inputRightChannelData[DSPiterator]);
         
         // Store the collected samples into the buffer, and check for size:
         grainBuffer.writeVal(inputSampleLeft, inputSampleRight);
         grainBuffer.setBufferSize(*bufferSizeParam);
         
+        // Keep the STFT of the buffer up to date while "Blender" is on, so that spectral grains can start at any time:
+        if (spectralMode && ! grainBuffer.isFrozen())
+            spectralGrains.write (grainBuffer.getWritePos(), inputSampleLeft, inputSampleRight);
+        
         // Initialise out samples:
         float outSampleLeft = 0.0f;
         float outSampleRight = 0.0f;
         
         // Following operations done at a grain level:
-        for (int i=0; i<maxGrainCount; i++)
+        for (int i=0; i<numVoices; i++)
         {
             // Process the ith grain:
             grains[i].process(*grainLengthParam,
@@ -175,50 +581,161 @@ void TabboulehAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, ju
                               *chanceToSkipGrainParam,
                               *grainStereoRandomnessParam);
             
+            if (snapToOnsets && grains[i].newGrainStarted())
+            {
+                // A frozen buffer's onsets were marked by its analysis, once it is done:
+                auto readPos = (int) grains[i].getReadPos();
+                auto endPos = (int) grainBuffer.getMaxReadPos();
+                auto onset = useFreezeAnalysis ? freezeAnalysis.findNearestOnset (readPos, maxSnapDistance, endPos)
+                                               : grainBuffer.getOnsetIndex().findNearest (readPos, maxSnapDistance, endPos);
+                
+                if (onset >= 0)
+                    grains[i].setReadPos (onset);
+            }
+            
+            if (grains[i].newGrainStarted() && grainManager.getVolumeForGrain(i) > 0.0f)
+            {
+                performanceCounters.addGrainStart (grains[i].isSkipped());
+                
+                if (recordTrace)
+                    traceRecorder.addInstant (grains[i].isSkipped() ? TraceEvent::grainSkipped : TraceEvent::grainStarted, i, grains[i].getReadPos());
+            }
+            
+            if (spectralMode && grains[i].newGrainStarted())
+                spectralGrains.startGrain (i, (int) grains[i].getReadPos());
+            
+            if (filterGrains && grains[i].newGrainStarted())
+                grainFilters.startGrain (i);
+            
+            if (grains[i].newGrainStarted())
+                grainReadsFile[(size_t) i] = fileGrainChance > 0.0f && sourceRandom.nextFloat() < fileGrainChance;
+            
+            if (publishTelemetry && grains[i].newGrainStarted())
+                telemetry.push ({ TelemetryEvent::grainStarted, (juce::uint8) i, (int) grains[i].getReadPos(), grainManager.getVolumeForGrain(i) });
+            
             // Get the right and left out samples from active grains (0 for inactive):
-            float unprocessedGrainSampleL = grainBuffer.readValL(grains[i].getReadPos()) * grainManager.getVolumeForGrain(i);
-            float unprocessedGrainSampleR = grainBuffer.readValR(grains[i].getReadPos()) * grainManager.getVolumeForGrain(i);
+            float unprocessedGrainSampleL = 0.0f;
+            float unprocessedGrainSampleR = 0.0f;
+            
+            // File grains read silence from the parts of the file not in memory yet:
+            if (readGrains && fileGrainChance > 0.0f && grainReadsFile[(size_t) i])
+            {
+                fileSource.read (fileWindowStart + (juce::int64) grains[i].getReadPos(), unprocessedGrainSampleL, unprocessedGrainSampleR);
+            }
+            else if (readGrains)
+            {
+                unprocessedGrainSampleL = grainBuffer.readValL(grains[i].getReadPos());
+                unprocessedGrainSampleR = grainBuffer.readValR(grains[i].getReadPos());
+            }
+            
+            unprocessedGrainSampleL *= grainManager.getVolumeForGrain(i);
+            unprocessedGrainSampleR *= grainManager.getVolumeForGrain(i);
             
-            // Write in L/R Samples into FFT buffers and process the instance.
-            fftsynths[i].writeInSamples(unprocessedGrainSampleL,
-                                        unprocessedGrainSampleR,
-                                        grains[i].newGrainStarted(),
-                                        *synthVolumeThresholdParam,
-                                        *chanceToSkipGrainParam,
-                                        *grainStereoRandomnessParam);
+            float synthOut = 0.0f;
             
-            // Set envelope parameters in synths:
-            fftsynths[i].setEnvelopeParams(*synthEnvelopeShapeParam, *grainLengthParam);
+            // Synths that can't be heard are stopped (see processBlock), and neither listen nor play:
+            if (! synthsBypassed)
+            {
+                if (useFreezeAnalysis)
+                {
+                    // Look the grain's analysis up:
+                    auto& frame = freezeAnalysis.getFrameAt (grains[i].getReadPos());
+                    fftsynths[i].writeInAnalysedGrain(frame.frequency,
+                                                      frame.peak * grainManager.getVolumeForGrain(i),
+                                                      grains[i].newGrainStarted(),
+                                                      *synthVolumeThresholdParam,
+                                                      *chanceToSkipGrainParam,
+                                                      *grainStereoRandomnessParam);
+                }
+                else
+                {
+                    // Write in L/R Samples into FFT buffers and process the instance.
+                    fftsynths[i].writeInSamples(unprocessedGrainSampleL,
+                                                unprocessedGrainSampleR,
+                                                grains[i].newGrainStarted(),
+                                                *synthVolumeThresholdParam,
+                                                *chanceToSkipGrainParam,
+                                                *grainStereoRandomnessParam);
+                }
+                
+                if (publishTelemetry && fftsynths[i].isNoteStarting())
+                    telemetry.push ({ TelemetryEvent::synthNoteStarted, (juce::uint8) i, 0,
+                                      fftsynths[i].getDetectedFrequency(), fftsynths[i].getNoteFrequency(), fftsynths[i].getSynthVolume() });
+                
+                if (recordTrace && fftsynths[i].isNoteStarting())
+                    traceRecorder.addInstant (TraceEvent::synthTriggered, i, fftsynths[i].getNoteFrequency());
+                
+                // Set envelope parameters in synths:
+                fftsynths[i].setEnvelopeParams(*synthEnvelopeShapeParam, *grainLengthParam);
+                
+                // Get the output of th synth:
+                synthOut = fftsynths[i].processSynth<oscillators>(*synthOscillatorSelectParam) * *synthVolumeParam;
+            }
             
-            // Get the output of th synth:
-            float synthOut = fftsynths[i].processSynth(*synthOscillatorSelectParam) * *synthVolumeParam;
+            // Spectral grains are resynthesised together below, only their gains are needed here:
+            if (spectralMode)
+            {
+                float spectralGain = (2.0f/float(*activeGrainsParam)) * grainManager.getVolumeForGrain(i) * *grainVolumeParam;
+                spectralGrains.setGain (i, spectralGain * grains[i].getStereoVolumeLeft(), spectralGain * grains[i].getStereoVolumeRight());
+                
+                outSampleLeft  += synthOut * fftsynths[i].getStereoVolumeLeft();
+                outSampleRight += synthOut * fftsynths[i].getStereoVolumeRight();
+                continue;
+            }
+            
+            // Silent grains only leave the synth:
+            if (grainsBypassed)
+            {
+                outSampleLeft  += synthOut * fftsynths[i].getStereoVolumeLeft();
+                outSampleRight += synthOut * fftsynths[i].getStereoVolumeRight();
+                continue;
+            }
+            
+            // Calculate the Left and Right grain samples:
+            float grainSampleL = (((2.0f/float(*activeGrainsParam))
+                                 * unprocessedGrainSampleL
+                                 * grains[i].getStereoVolumeLeft()))
+                                 * *grainVolumeParam;
+            float grainSampleR = (((2.0f/float(*activeGrainsParam))
+                                 * unprocessedGrainSampleR
+                                 * grains[i].getStereoVolumeRight()))
+                                 * *grainVolumeParam;
+            
+            // Filtered grains are added all at once below, after every voice:
+            if (filterGrains)
+            {
+                grainFilters.setInput (i, grainSampleL, grainSampleR);
+                grainSampleL = 0.0f;
+                grainSampleR = 0.0f;
+            }
             
             // Calculate the Left sample:
-            float outGrainSampleL = (((2.0f/float(*activeGrainsParam))
-                                    * unprocessedGrainSampleL
-                                    * grains[i].getStereoVolumeLeft()))
-                                    * *grainVolumeParam
-                                    + (synthOut * fftsynths[i].getStereoVolumeLeft());
+            float outGrainSampleL = grainSampleL + (synthOut * fftsynths[i].getStereoVolumeLeft());
 
             // Calculate the Right sample:
-            float outGrainSampleR = (((2.0f/float(*activeGrainsParam))
-                                    * unprocessedGrainSampleR
-                                    * grains[i].getStereoVolumeRight()))
-                                    * *grainVolumeParam
-                                    + (synthOut * fftsynths[i].getStereoVolumeRight());
+            float outGrainSampleR = grainSampleR + (synthOut * fftsynths[i].getStereoVolumeRight());
             
             // Add the L/R samples to the main output:
             outSampleLeft  += outGrainSampleL;
             outSampleRight += outGrainSampleR;
         }
         
-        // Write samples to output:
-        outputLeftChannelData[DSPiterator]  = outSampleLeft;
-        outputRightChannelData[DSPiterator] = outSampleRight;
+        if (spectralMode)
+            spectralGrains.process (outSampleLeft, outSampleRight);
         
-        // Update Reverb Parameters:
-        setReverbParams(reverbParams, *reverbAmountParam, *grainStereoRandomnessParam);
-        reverb.setParameters(reverbParams);
+        if (filterGrains)
+            grainFilters.process (outSampleLeft, outSampleRight);
+        
+        // Write samples to output, mixed down to mono if need be:
+        if (numChannels == 1)
+        {
+            outputLeftChannelData[DSPiterator] = (outSampleLeft + outSampleRight) * 0.5f;
+        }
+        else
+        {
+            outputLeftChannelData[DSPiterator]  = outSampleLeft;
+            outputRightChannelData[DSPiterator] = outSampleRight;
+        }
         
         //=============
         // HERE ONLY FOR TESTING, zone for breakpoint if necessary! DELETE WHEN DONE!
@@ -229,15 +746,41 @@ void TabboulehAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, ju
 //        }
         //=============
     }
-    
-    // Apply reverb to buffer
-    reverb.processStereo(outputLeftChannelData, outputRightChannelData, buffer.getNumSamples());
+}
+
+template <size_t... variants>
+constexpr std::array<TabboulehAudioProcessor::RenderFunction, sizeof... (variants)> TabboulehAudioProcessor::makeRenderFunctions (std::index_sequence<variants...>)
+{
+    // Variants are numbered as in getRenderVariant:
+    return { &TabboulehAudioProcessor::renderVoices<(int) (variants / (2 * numOscillatorSets)) + 1,
+                                                    (int) (variants / numOscillatorSets) % 2 + 1,
+                                                    (OscillatorSet) (variants % numOscillatorSets)>... };
+}
+
+const std::array<TabboulehAudioProcessor::RenderFunction, TabboulehAudioProcessor::numRenderVariants> TabboulehAudioProcessor::renderFunctions
+    = TabboulehAudioProcessor::makeRenderFunctions (std::make_index_sequence<TabboulehAudioProcessor::numRenderVariants>());
+
+int TabboulehAudioProcessor::getRenderVariant (int numVoices, int numChannels, OscillatorSet oscillators)
+{
+    return ((numVoices - 1) * 2 + (numChannels - 1)) * numOscillatorSets + (int) oscillators;
 }
 
 void TabboulehAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    stopTimer();
+}
+
+void TabboulehAudioProcessor::timerCallback()
+{
+    freezeAnalysis.launchIfRequested (*analysisThread);
+    convolutionReverb.collectGarbage();
+    
+    auto level = (float) qualityGovernor.getLevel();
+    
+    if (qualityLevelParam->convertFrom0to1 (qualityLevelParam->getValue()) != level)
+        qualityLevelParam->setValueNotifyingHost (qualityLevelParam->convertTo0to1 (level));
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -302,7 +845,24 @@ bool TabboulehAudioProcessor::isMidiEffect() const
 
 double TabboulehAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // A frozen buffer plays forever:
+    if (*freezeParam > 0.5f)
+        return std::numeric_limits<double>::infinity();
+    
+
+    // The buffer plays back up to "Bowl Size" seconds of past input, in grains lasting "Parsley Chop".
+    // The last of those grains starts a synth note as long as itself, and "Oil" rings on after that.
+    FDNReverb::Parameters tailReverbParams;
+    setReverbParams(tailReverbParams, *reverbAmountParam, *grainStereoRandomnessParam);
+    
+    // A convolution rings for as long as its impulse response:
+    auto reverbTail = *convolutionParam > 0.5f && convolutionReverb.getTailLengthSeconds() > 0.0 ? convolutionReverb.getTailLengthSeconds()
+                                                                                                  : FDNReverb::getTailLengthSeconds (tailReverbParams);
+    
+    // Spectral grains are heard an FFT later.
+    auto spectralLatency = *spectralModeParam > 0.5f ? SpectralGrains::getLatencyInSamples() / (double) sampleRate : 0.0;
+    
+    return *bufferSizeParam + 2.0f * *grainLengthParam + reverbTail + spectralLatency;
 }
 
 int TabboulehAudioProcessor::getNumPrograms()
@@ -330,6 +890,12 @@ void TabboulehAudioProcessor::changeProgramName (int index, const juce::String&
 }
 
 
+//==============================================================================
+bool TabboulehAudioProcessor::loadImpulseResponse (const juce::File& file)
+{
+    return convolutionReverb.loadImpulseResponse (file);
+}
+
 //==============================================================================
 bool TabboulehAudioProcessor::hasEditor() const
 {
@@ -338,7 +904,7 @@ bool TabboulehAudioProcessor::hasEditor() const
 
 juce::AudioProcessorEditor* TabboulehAudioProcessor::createEditor()
 {
-    return new juce::GenericAudioProcessorEditor (*this);
+    return new TabboulehAudioProcessorEditor (*this);
 }
 
 //==============================================================================
@@ -347,17 +913,39 @@ void TabboulehAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
     // You should use this method to store your parameters in the memory block.
     // You could do that either as raw data, or use the XML or ValueTree classes
     // as intermediaries to make it easy to save and load complex data.
-    // getStateInformation
-    auto state = parameters.copyState();
-    std::unique_ptr<juce::XmlElement> xml (state.createXml());
-    copyXmlToBinary (*xml, destData);
+    // getStateInformation, written straight from the parameters (see BinaryState.h):
+    BinaryState::write (*this, destData, convolutionReverb.getImpulseResponseFile().getFullPathName(), fileSource.getFile().getFullPathName());
 }
 
 void TabboulehAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
-    // setStateInformation
+    // setStateInformation, from the binary format, or the XML written by older versions:
+    juce::String impulseResponsePath, grainSourcePath;
+    
+    if (BinaryState::read (*this, data, sizeInBytes, &impulseResponsePath, &grainSourcePath))
+    {
+        // The impulse response is saved as its path, and left out if the file has gone:
+        if (impulseResponsePath.isEmpty())
+            convolutionReverb.clearImpulseResponse();
+        else if (juce::File (impulseResponsePath) != convolutionReverb.getImpulseResponseFile())
+            convolutionReverb.loadImpulseResponse (juce::File (impulseResponsePath));
+        
+        // So is the grain source, loaded in the background:
+        if (grainSourcePath.isEmpty())
+        {
+            if (fileSource.getFile() != juce::File())
+                fileSource.clearFile();
+        }
+        else if (juce::File (grainSourcePath) != fileSource.getFile())
+        {
+            fileSource.loadFile (juce::File (grainSourcePath));
+        }
+        
+        return;
+    }
+    
     std::unique_ptr<juce::XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
     if (xmlState.get() != nullptr)
     {
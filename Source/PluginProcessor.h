@@ -13,12 +13,28 @@
 #include "CustomFunctions.h"
 #include "Grain.h"
 #include "FFTSynth.h"
+#include "QualityGovernor.h"
+#include "FreezeAnalysis.h"
+#include "Telemetry.h"
+#include "PerformanceCounters.h"
+#include "TraceRecorder.h"
+#include "SpectralGrains.h"
+#include "ConvolutionReverb.h"
+#include "MyFilters.h"
+#include "FileGrainSource.h"
 #include <vector>
+#include <array>
+#include <utility>
+
+#ifndef TABBOULEH_COMPACT_HISTORY
+ #define TABBOULEH_COMPACT_HISTORY 0
+#endif
 
 //==============================================================================
 /**
 */
-class TabboulehAudioProcessor  : public juce::AudioProcessor
+class TabboulehAudioProcessor  : public juce::AudioProcessor,
+                                 private juce::Timer
 {
 public:
     //==============================================================================
@@ -58,7 +74,98 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    //==============================================================================
+    /// The governor lowering quality when processBlock gets too close to its deadline, see QualityGovernor.h
+    QualityGovernor& getQualityGovernor()  { return qualityGovernor; }
+    
+    /// Events published by processBlock for the editor, see Telemetry.h
+    Telemetry& getTelemetry()  { return telemetry; }
+    
+    /// Counters of what processBlock does and how long it takes, readable from any thread, see PerformanceCounters.h
+    const PerformanceCounters& getPerformanceCounters() const  { return performanceCounters; }
+    
+    /// Timeline of what processBlock does, written to a trace file while recording, see TraceRecorder.h
+    TraceRecorder& getTraceRecorder()  { return traceRecorder; }
+    
+    /**
+     Starts loading an impulse response for "Oil" to convolve with when "Extra Virgin" is on, and returns straight
+     away: the file is read and partitioned in the background (see ConvolutionReverb). Call from the message thread.
+     
+     @param file audio file holding the impulse response
+     @return false if the file can't be read, in which case the last impulse response is kept
+     */
+    bool loadImpulseResponse (const juce::File& file);
+    
+    /// Returns the file of the impulse response in use, or about to be, or an empty File if there isn't one.
+    juce::File getImpulseResponseFile() const  { return convolutionReverb.getImpulseResponseFile(); }
+    
+    /**
+     Waits for the impulse response to be loaded, for offline renders that must not start without it.
+     
+     @return true if the impulse response is ready
+     */
+    bool waitForImpulseResponse (int timeoutMilliseconds)  { return convolutionReverb.waitUntilLoaded (timeoutMilliseconds); }
+    
+    /**
+     Starts loading an audio file for the grains to read from when "Pantry" is up, and returns straight away: the file
+     is decoded in the background (see FileGrainSource). Call from the message thread.
+     
+     @param file audio file to read from, or an empty File to stop reading from one
+     */
+    void loadGrainSourceFile (const juce::File& file)  { fileSource.loadFile (file); }
+    
+    /// Returns the file the grains read from, or are about to, or an empty File if there isn't one.
+    juce::File getGrainSourceFile() const  { return fileSource.getFile(); }
+    
+    /// Returns where loading the grain source file is at.
+    FileGrainSource::Status getGrainSourceStatus() const  { return fileSource.getStatus(); }
+    
+    /**
+     Waits for the grain source file to be loaded, for offline renders that must not start without it.
+     
+     @return true if the file is ready
+     */
+    bool waitForGrainSourceFile (int timeoutMilliseconds)  { return fileSource.waitUntilLoaded (timeoutMilliseconds); }
+    
+    /**
+     Makes every random choice of the grains and synths repeatable, for renders that must match from one run to the
+     next. The sequences start again from the seed on every prepareToPlay(). By default, they are seeded from the time.
+     
+     @param seed seed of the first grain, the others use the following ones
+     */
+    void setRandomSeed (juce::int64 seed)  { randomSeed = seed; hasRandomSeed = true; }
+    
+    /**
+     Sets how the GrainBuffer stores its samples, from the next prepareToPlay() on. Half floats halve the memory of the
+     buffer, for a signal to noise ratio above 70 dB. The default is set by TABBOULEH_COMPACT_HISTORY.
+     */
+    void setHistoryStorage (GrainBuffer::Storage storage)  { historyStorage = storage; }
+
 private:
+    //==============================================================================
+    /// Reports the quality level to the host and the editor, and starts the analysis of frozen buffers, from the message thread.
+    void timerCallback() override;
+    
+    //==============================================================================
+    // Render loop variants, one per number of voices, number of channels and set of oscillators heard:
+    using RenderFunction = void (TabboulehAudioProcessor::*) (juce::AudioBuffer<float>&, bool, bool, bool);
+    static constexpr int maxGrainCount = 5;
+    static constexpr int numOscillatorSets = (int) OscillatorSet::numSets;
+    static constexpr int numRenderVariants = maxGrainCount * 2 * numOscillatorSets;
+    
+    template <int numVoices, int numChannels, OscillatorSet oscillators>
+    void renderVoices (juce::AudioBuffer<float>& buffer, bool useFreezeAnalysis, bool publishTelemetry, bool recordTrace);
+    
+    template <size_t... variants>
+    static constexpr std::array<RenderFunction, sizeof... (variants)> makeRenderFunctions (std::index_sequence<variants...>);
+    
+    /// Returns the index in renderFunctions of the variant for the given configuration.
+    static int getRenderVariant (int numVoices, int numChannels, OscillatorSet oscillators);
+    
+    static const std::array<RenderFunction, numRenderVariants> renderFunctions;
+    RenderFunction renderFunction = nullptr;        // Variant used for the last block
+    int renderVariant = -1;
+
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TabboulehAudioProcessor)
     
@@ -69,22 +176,73 @@ private:
      
     // GENERAL VARIABLES:
     int sampleRate;
-    int maxGrainCount = 5;
-    int maxFftSynthCount = maxGrainCount;
+    juce::int64 randomSeed = 0;
+    bool hasRandomSeed = false;
+    static constexpr int maxFftSynthCount = maxGrainCount;
     // Filters
     juce::IIRFilter hpFilterL;
     juce::IIRFilter hpFilterR;
     std::atomic<float>* hpFrequencyParam;
+    float hpFrequency = 0.0f;                               // "Lemon" the coefficients were last worked out for
     // Reverb
-    juce::Reverb reverb;
-    juce::Reverb::Parameters reverbParams;
+    FDNReverb reverb;
+    FDNReverb::Parameters reverbParams;
+    juce::AudioBuffer<float> reverbReturn;
     std::atomic<float>* reverbAmountParam;
+    ConvolutionReverb convolutionReverb;
+    std::atomic<float>* convolutionParam;
+    std::atomic<float>* reverbLushParam;
+    bool usedConvolution = false;                           // Which reverb the last block went through
+    bool reverbBypassed = false;                            // "Oil" at 0, only the dry signal goes through
+    // Silence
+    static constexpr float silenceThreshold = 0.00003f;    // About -90 dB
+    juce::int64 samplesSinceSound = 0;                      // Samples since the input was last above the threshold
+    bool isIdle = false;                                    // True once every tail has died out
+    // Sections that can't be heard, and skip their work
+    bool grainsBypassed = false;                            // "Parsley Amount" at 0, the grains aren't rendered
+    bool synthsBypassed = false;                            // "Tomato Amount" at 0, the synths neither listen nor play
+    // CPU load
+    QualityGovernor qualityGovernor;
+    juce::RangedAudioParameter* qualityLevelParam;
+    // Visualisation
+    Telemetry telemetry;
+    PerformanceCounters performanceCounters;
+    TraceRecorder traceRecorder;
     
     
     // BUFFER RELATED VARIABLES:
     GrainBuffer grainBuffer;
+    GrainBuffer::Storage historyStorage = TABBOULEH_COMPACT_HISTORY ? GrainBuffer::Storage::float16 : GrainBuffer::Storage::float32;
     float maxDelaySizeInSeconds = 5.0f;
     std::atomic<float>* bufferSizeParam;
+    // Freeze
+    FreezeAnalysis freezeAnalysis { grainBuffer };
+    juce::SharedResourcePointer<FreezeAnalysis::BackgroundThread> analysisThread;
+    std::atomic<float>* freezeParam;
+    // Onsets
+    std::atomic<float>* onsetSnapParam;
+    // Spectral grains
+    SpectralGrains spectralGrains;
+    static constexpr int spectralCatchUpPerBlock = 4 * SpectralGrains::hopSize;
+    bool spectralOn = false;                                // "Blender" on for the current block, analysing the buffer
+    int spectralCatchUpPosition = -1;                       // Next sample of a held buffer to analyse, -1 when done
+    std::atomic<float>* spectralModeParam;
+    std::atomic<float>* spectralStretchParam;
+    std::atomic<float>* spectralSmearParam;
+    // Grain filters
+    GrainFilterBank grainFilters;
+    std::atomic<float>* grainFilterParam;
+    std::atomic<float>* grainFilterCutoffParam;
+    std::atomic<float>* grainFilterResonanceParam;
+    std::atomic<float>* grainFilterRandomnessParam;
+    // File source
+    FileGrainSource fileSource;
+    std::atomic<float>* sourceChanceParam;
+    std::atomic<float>* sourcePositionParam;
+    std::array<bool, maxGrainCount> grainReadsFile {};  // Per grain, drawn when it starts
+    float fileGrainChance = 0.0f;                   // Chance a new grain reads from the file, 0 without one
+    juce::int64 fileWindowStart = 0;                // Frame of the file the buffer's start maps to
+    juce::Random sourceRandom;
 
     
     // GRAIN RELATED VARIABLES:
@@ -106,6 +264,8 @@ private:
     std::atomic<float>* synthVolumeParam;
     std::atomic<float>* synthEnvelopeShapeParam;
     std::atomic<float>* synthVolumeThresholdParam;
+    std::atomic<float>* synthBandLowParam;              // "Tomato Roots", lower edge of the band the synths listen to
+    std::atomic<float>* synthBandHighParam;             // "Tomato Leaves", its upper edge
     std::atomic<float>* frequencyPrecisionParam;
     std::atomic<float>* freqAParam;
 
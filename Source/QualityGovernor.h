@@ -0,0 +1,193 @@
+/*
+  ==============================================================================
+
+    QualityGovernor.h
+    Created: 18 Oct 2026 4:47:26pm
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ Keeps processBlock within its deadline by trading quality for CPU time when the load gets too high.
+
+ The time spent in each block is compared to the time the block lasts at the project's sample rate. That load is
+ smoothed, and when it stays above the step down threshold the governor lowers the quality by one level. Once the
+ load has stayed below the step up threshold for the recovery time, it raises it again by one level, so that it
+ doesn't flip back and forth around a threshold.
+
+ Each level keeps the savings of the ones before it:
+ 1. fewer FFTSynths analyse their grains,
+ 2. the analysis uses a smaller FFT,
+ 3. no analysis at all (playing synth notes still finish),
+ 4. fewer grains are played.
+
+ Call beginBlock() at the start of processBlock and endBlock() at its end; the level can be read from any thread.
+ */
+class QualityGovernor
+{
+public:
+
+    enum Level
+    {
+        fullQuality = 0,
+        fewerAnalysisVoices,
+        smallerFFT,
+        noSynthAnalysis,
+        fewerGrains,
+        numLevels
+    };
+
+    /// Thresholds, as a fraction of the block's duration.
+    struct Settings
+    {
+        float stepDownLoad = 0.75f;         // Smoothed load above which quality is lowered
+        float stepUpLoad = 0.4f;            // Smoothed load below which quality may be raised
+        float smoothingSeconds = 0.1f;      // Time constant of the load smoothing
+        float stepDownHoldSeconds = 0.25f;  // Minimum time between two steps down, to let the last one take effect
+        float recoverySeconds = 2.0f;       // Time the load must stay low before quality is raised
+        int analysisVoicesWhenReduced = 2;  // FFTSynths still analysing from fewerAnalysisVoices
+        int grainsWhenReduced = 3;          // Grains still playing at fewerGrains
+    };
+
+    /// Sets the sample rate used to work out the deadlines, and goes back to full quality.
+    void prepare (double _sampleRate)
+    {
+        sampleRate = _sampleRate;
+        smoothedLoad = 0.0f;
+        publishedLoad = 0.0f;
+        secondsSinceStepDown = 0.0f;
+        secondsBelowStepUp = 0.0f;
+        level = fullQuality;
+    }
+
+    void setSettings (const Settings& newSettings)
+    {
+        settings = newSettings;
+    }
+
+    const Settings& getSettings() const
+    {
+        return settings;
+    }
+
+    /// When disabled, as when rendering offline, the governor stays at full quality.
+    void setEnabled (bool shouldBeEnabled)
+    {
+        enabled = shouldBeEnabled;
+
+        if (! enabled)
+            level = fullQuality;
+    }
+
+    /// Marks the start of a block.
+    void beginBlock()
+    {
+        blockStartTicks = juce::Time::getHighResolutionTicks();
+    }
+
+    /**
+     Marks the end of a block, measures its load and updates the level.
+
+     @param numSamples length of the block
+     @return true if the level changed
+     */
+    bool endBlock (int numSamples)
+    {
+        if (! enabled || numSamples <= 0)
+            return false;
+
+        auto elapsedSeconds = (float) juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - blockStartTicks);
+        auto blockSeconds = (float) (numSamples / sampleRate);
+        auto load = elapsedSeconds / blockSeconds;
+
+        smoothedLoad += (load - smoothedLoad) * (1.0f - std::exp (-blockSeconds / settings.smoothingSeconds));
+        publishedLoad.store (smoothedLoad, std::memory_order_relaxed);
+        secondsSinceStepDown += blockSeconds;
+
+        auto currentLevel = level.load (std::memory_order_relaxed);
+
+        if (smoothedLoad > settings.stepDownLoad)
+        {
+            secondsBelowStepUp = 0.0f;
+
+            if (currentLevel < numLevels - 1 && secondsSinceStepDown >= settings.stepDownHoldSeconds)
+            {
+                level.store (currentLevel + 1, std::memory_order_relaxed);
+                secondsSinceStepDown = 0.0f;
+                return true;
+            }
+        }
+        else if (smoothedLoad < settings.stepUpLoad)
+        {
+            secondsBelowStepUp += blockSeconds;
+
+            if (currentLevel > fullQuality && secondsBelowStepUp >= settings.recoverySeconds)
+            {
+                level.store (currentLevel - 1, std::memory_order_relaxed);
+                secondsBelowStepUp = 0.0f;
+                return true;
+            }
+        }
+        else
+        {
+            secondsBelowStepUp = 0.0f;
+        }
+
+        return false;
+    }
+
+    /// Returns the current level, from fullQuality to fewerGrains.
+    int getLevel() const
+    {
+        return level.load (std::memory_order_relaxed);
+    }
+
+    /// Returns the smoothed load, as a fraction of the block duration.
+    float getLoad() const
+    {
+        return publishedLoad.load (std::memory_order_relaxed);
+    }
+
+    /// Returns how many of the FFTSynths may analyse their grains.
+    int getNumAnalysisVoices (int numVoices) const
+    {
+        if (getLevel() >= noSynthAnalysis)
+            return 0;
+
+        if (getLevel() >= fewerAnalysisVoices)
+            return std::min (numVoices, settings.analysisVoicesWhenReduced);
+
+        return numVoices;
+    }
+
+    /// Returns true if the analysis should use the smaller FFT.
+    bool useSmallerFFT() const
+    {
+        return getLevel() >= smallerFFT;
+    }
+
+    /// Returns how many grains may play.
+    int getNumGrains (int numGrains) const
+    {
+        if (getLevel() >= fewerGrains)
+            return std::min (numGrains, settings.grainsWhenReduced);
+
+        return numGrains;
+    }
+
+    //==========================================================================
+private:
+    Settings settings;
+    double sampleRate = 44100.0;
+    bool enabled = true;
+    std::atomic<int> level { fullQuality };
+    std::atomic<float> publishedLoad { 0.0f };
+    juce::int64 blockStartTicks = 0;
+    float smoothedLoad = 0.0f;
+    float secondsSinceStepDown = 0.0f;
+    float secondsBelowStepUp = 0.0f;
+};
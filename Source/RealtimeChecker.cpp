@@ -0,0 +1,375 @@
+/*
+  ==============================================================================
+
+    RealtimeChecker.cpp
+    Created: 18 Oct 2026 1:12:31pm
+
+  ==============================================================================
+*/
+
+#if TABBOULEH_REALTIME_CHECKS
+
+#include "RealtimeChecker.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+
+#if defined (__linux__)
+ #include <dlfcn.h>
+ #include <execinfo.h>
+ #include <cxxabi.h>
+ #include <pthread.h>
+ #include <semaphore.h>
+ #include <poll.h>
+ #include <fcntl.h>
+ #include <time.h>
+ #include <unistd.h>
+ #define TABBOULEH_INTERCEPT_LIBC 1
+#else
+ #define TABBOULEH_INTERCEPT_LIBC 0
+#endif
+
+// Stack traces skip a fixed number of frames, which must not be inlined away:
+#if defined (_MSC_VER)
+ #define TABBOULEH_NO_INLINE __declspec (noinline)
+#else
+ #define TABBOULEH_NO_INLINE __attribute__ ((noinline))
+#endif
+
+//==============================================================================
+namespace
+{
+    /// A distinct violation: the stack it happened on, and how many times it did.
+    struct Violation
+    {
+        const char* functionName;
+        void* frames[RealtimeChecker::maxStackFrames];
+        int numFrames;
+        std::atomic<int> count;
+    };
+
+    Violation violations[RealtimeChecker::maxDistinctViolations];
+    std::atomic<int> numDistinctViolations { 0 };
+    std::atomic<int> numViolations { 0 };
+    std::atomic<bool> abortOnViolation { false };
+
+    /// Stack capture, which works from any thread without allocating once warmed up by enable().
+    TABBOULEH_NO_INLINE int captureStack (void** frames, int maxFrames)
+    {
+       #if TABBOULEH_INTERCEPT_LIBC
+        return backtrace (frames, maxFrames);
+       #else
+        (void) frames; (void) maxFrames;
+        return 0;
+       #endif
+    }
+
+    void printViolation (std::ostream& stream, const Violation& violation)
+    {
+        stream << "Realtime violation: " << violation.functionName << " called "
+               << violation.count.load() << " time(s) in a realtime section" << std::endl;
+
+       #if TABBOULEH_INTERCEPT_LIBC
+        auto** symbols = backtrace_symbols (violation.frames, violation.numFrames);
+
+        // Frames 0 to 2 are captureStack, checkCall and the intercepting function:
+        for (int i=3; i<violation.numFrames && symbols != nullptr; i++)
+        {
+            // Symbols look like "binary(mangled+0x1f) [0x...]", demangle the part between '(' and '+':
+            auto* symbol = symbols[i];
+            auto* nameStart = std::strchr (symbol, '(');
+            auto* nameEnd = nameStart != nullptr ? std::strchr (nameStart, '+') : nullptr;
+            int status = -1;
+            char* demangled = nullptr;
+
+            if (nameStart != nullptr && nameEnd != nullptr && nameEnd > nameStart + 1)
+            {
+                std::string mangledName (nameStart + 1, nameEnd);
+                demangled = abi::__cxa_demangle (mangledName.c_str(), nullptr, nullptr, &status);
+            }
+
+            stream << "    #" << (i - 3) << "  " << (status == 0 ? demangled : symbol) << std::endl;
+            std::free (demangled);
+        }
+
+        std::free (symbols);
+       #endif
+    }
+}
+
+thread_local int RealtimeChecker::realtimeSectionDepth = 0;
+thread_local bool RealtimeChecker::isRecording = false;
+
+//==============================================================================
+TABBOULEH_NO_INLINE void RealtimeChecker::checkCall (const char* functionName)
+{
+    if (realtimeSectionDepth == 0 || isRecording)
+        return;
+
+    // Anything called from here on (backtrace, printing) must not be reported again:
+    isRecording = true;
+    numViolations++;
+
+    void* frames[maxStackFrames];
+    auto numFrames = captureStack (frames, maxStackFrames);
+
+    // Count the violation against an identical stack if there is one, otherwise claim a new slot:
+    bool found = false;
+    auto numDistinct = std::min (numDistinctViolations.load(), (int) maxDistinctViolations);
+
+    for (int i=0; i<numDistinct && ! found; i++)
+    {
+        if (violations[i].numFrames == numFrames && std::memcmp (violations[i].frames, frames, sizeof (void*) * (size_t) numFrames) == 0)
+        {
+            violations[i].count++;
+            found = true;
+        }
+    }
+
+    if (! found)
+    {
+        auto index = numDistinctViolations++;
+
+        if (index < maxDistinctViolations)
+        {
+            auto& violation = violations[index];
+            violation.functionName = functionName;
+            violation.numFrames = numFrames;
+            std::memcpy (violation.frames, frames, sizeof (void*) * (size_t) numFrames);
+            violation.count = 1;
+
+            if (abortOnViolation)
+            {
+                printViolation (std::cerr, violation);
+                std::abort();
+            }
+        }
+    }
+
+    isRecording = false;
+}
+
+int RealtimeChecker::getNumViolations()
+{
+    return numViolations;
+}
+
+void RealtimeChecker::printViolations (std::ostream& stream)
+{
+    auto numDistinct = std::min (numDistinctViolations.load(), (int) maxDistinctViolations);
+
+    for (int i=0; i<numDistinct; i++)
+        printViolation (stream, violations[i]);
+
+    if (numDistinctViolations > maxDistinctViolations)
+        stream << (numDistinctViolations - maxDistinctViolations) << " more distinct violation(s) were not recorded" << std::endl;
+}
+
+void RealtimeChecker::clearViolations()
+{
+    numDistinctViolations = 0;
+    numViolations = 0;
+}
+
+void RealtimeChecker::setAbortOnViolation (bool shouldAbort)
+{
+    abortOnViolation = shouldAbort;
+}
+
+//==============================================================================
+#if TABBOULEH_INTERCEPT_LIBC
+
+/*
+ On Linux, the functions below replace the C library's own for the whole executable. The memory functions forward to
+ glibc's internal entry points, everything else to the next definition found by dlsym.
+ */
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void  __libc_free (void*);
+    void* __libc_memalign (size_t, size_t);
+}
+
+namespace
+{
+    /// Returns the next definition of an intercepted function, looking it up the first time it's needed.
+    template <typename FunctionType>
+    FunctionType next (FunctionType& cachedFunction, const char* name)
+    {
+        if (cachedFunction == nullptr)
+            cachedFunction = reinterpret_cast<FunctionType> (dlsym (RTLD_NEXT, name));
+
+        return cachedFunction;
+    }
+
+    int  (*nextMutexLock) (pthread_mutex_t*);
+    int  (*nextRwlockRdlock) (pthread_rwlock_t*);
+    int  (*nextRwlockWrlock) (pthread_rwlock_t*);
+    int  (*nextCondWait) (pthread_cond_t*, pthread_mutex_t*);
+    int  (*nextCondTimedwait) (pthread_cond_t*, pthread_mutex_t*, const struct timespec*);
+    int  (*nextJoin) (pthread_t, void**);
+    int  (*nextSemWait) (sem_t*);
+    int  (*nextNanosleep) (const struct timespec*, struct timespec*);
+    int  (*nextClockNanosleep) (clockid_t, int, const struct timespec*, struct timespec*);
+    int  (*nextUsleep) (useconds_t);
+    unsigned int (*nextSleep) (unsigned int);
+    int  (*nextPoll) (struct pollfd*, nfds_t, int);
+    ssize_t (*nextRead) (int, void*, size_t);
+    ssize_t (*nextWrite) (int, const void*, size_t);
+    int  (*nextOpen) (const char*, int, ...);
+    int  (*nextClose) (int);
+    int  (*nextFsync) (int);
+    FILE* (*nextFopen) (const char*, const char*);
+}
+
+void RealtimeChecker::enable()
+{
+    isRecording = true;
+
+    // The first backtrace loads the unwinder, which allocates; get it out of the way now:
+    void* frames[maxStackFrames];
+    captureStack (frames, maxStackFrames);
+
+    isRecording = false;
+}
+
+extern "C"
+{
+    // Memory
+    void* malloc (size_t size)                          { RealtimeChecker::checkCall ("malloc");         return __libc_malloc (size); }
+    void* calloc (size_t count, size_t size)            { RealtimeChecker::checkCall ("calloc");         return __libc_calloc (count, size); }
+    void* realloc (void* pointer, size_t size)          { RealtimeChecker::checkCall ("realloc");        return __libc_realloc (pointer, size); }
+    void* memalign (size_t alignment, size_t size)      { RealtimeChecker::checkCall ("memalign");       return __libc_memalign (alignment, size); }
+    void* aligned_alloc (size_t alignment, size_t size) { RealtimeChecker::checkCall ("aligned_alloc");  return __libc_memalign (alignment, size); }
+
+    void free (void* pointer)
+    {
+        if (pointer != nullptr)
+            RealtimeChecker::checkCall ("free");
+
+        __libc_free (pointer);
+    }
+
+    int posix_memalign (void** result, size_t alignment, size_t size)
+    {
+        RealtimeChecker::checkCall ("posix_memalign");
+        *result = __libc_memalign (alignment, size);
+        return *result != nullptr ? 0 : ENOMEM;
+    }
+
+    // Locks and waits
+    int pthread_mutex_lock (pthread_mutex_t* mutex)     { RealtimeChecker::checkCall ("pthread_mutex_lock");     return next (nextMutexLock, "pthread_mutex_lock") (mutex); }
+    int pthread_rwlock_rdlock (pthread_rwlock_t* lock)  { RealtimeChecker::checkCall ("pthread_rwlock_rdlock");  return next (nextRwlockRdlock, "pthread_rwlock_rdlock") (lock); }
+    int pthread_rwlock_wrlock (pthread_rwlock_t* lock)  { RealtimeChecker::checkCall ("pthread_rwlock_wrlock");  return next (nextRwlockWrlock, "pthread_rwlock_wrlock") (lock); }
+    int pthread_join (pthread_t thread, void** result)  { RealtimeChecker::checkCall ("pthread_join");           return next (nextJoin, "pthread_join") (thread, result); }
+    int sem_wait (sem_t* semaphore)                     { RealtimeChecker::checkCall ("sem_wait");               return next (nextSemWait, "sem_wait") (semaphore); }
+
+    int pthread_cond_wait (pthread_cond_t* condition, pthread_mutex_t* mutex)
+    {
+        RealtimeChecker::checkCall ("pthread_cond_wait");
+        return next (nextCondWait, "pthread_cond_wait") (condition, mutex);
+    }
+
+    int pthread_cond_timedwait (pthread_cond_t* condition, pthread_mutex_t* mutex, const struct timespec* time)
+    {
+        RealtimeChecker::checkCall ("pthread_cond_timedwait");
+        return next (nextCondTimedwait, "pthread_cond_timedwait") (condition, mutex, time);
+    }
+
+    // Sleeps
+    int nanosleep (const struct timespec* time, struct timespec* remaining)
+    {
+        RealtimeChecker::checkCall ("nanosleep");
+        return next (nextNanosleep, "nanosleep") (time, remaining);
+    }
+
+    int clock_nanosleep (clockid_t clock, int flags, const struct timespec* time, struct timespec* remaining)
+    {
+        RealtimeChecker::checkCall ("clock_nanosleep");
+        return next (nextClockNanosleep, "clock_nanosleep") (clock, flags, time, remaining);
+    }
+
+    int usleep (useconds_t microseconds)                { RealtimeChecker::checkCall ("usleep");  return next (nextUsleep, "usleep") (microseconds); }
+    unsigned int sleep (unsigned int seconds)           { RealtimeChecker::checkCall ("sleep");   return next (nextSleep, "sleep") (seconds); }
+
+    // Blocking IO
+    int poll (struct pollfd* fds, nfds_t numFds, int timeout)   { RealtimeChecker::checkCall ("poll");   return next (nextPoll, "poll") (fds, numFds, timeout); }
+    ssize_t read (int fd, void* data, size_t size)              { RealtimeChecker::checkCall ("read");   return next (nextRead, "read") (fd, data, size); }
+    ssize_t write (int fd, const void* data, size_t size)       { RealtimeChecker::checkCall ("write");  return next (nextWrite, "write") (fd, data, size); }
+    int close (int fd)                                          { RealtimeChecker::checkCall ("close");  return next (nextClose, "close") (fd); }
+    int fsync (int fd)                                          { RealtimeChecker::checkCall ("fsync");  return next (nextFsync, "fsync") (fd); }
+    FILE* fopen (const char* path, const char* mode)            { RealtimeChecker::checkCall ("fopen");  return next (nextFopen, "fopen") (path, mode); }
+
+    int open (const char* path, int flags, ...)
+    {
+        RealtimeChecker::checkCall ("open");
+
+        // The mode is only passed when a file may be created:
+        int mode = 0;
+
+        if ((flags & O_CREAT) != 0 || (flags & O_TMPFILE) == O_TMPFILE)
+        {
+            va_list arguments;
+            va_start (arguments, flags);
+            mode = va_arg (arguments, int);
+            va_end (arguments);
+        }
+
+        return next (nextOpen, "open") (path, flags, mode);
+    }
+}
+
+#else
+
+void RealtimeChecker::enable()
+{
+}
+
+// Elsewhere only operator new and delete can be replaced portably:
+void* operator new (std::size_t size)
+{
+    RealtimeChecker::checkCall ("operator new");
+
+    if (auto* pointer = std::malloc (size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)
+{
+    RealtimeChecker::checkCall ("operator new[]");
+
+    if (auto* pointer = std::malloc (size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void operator delete (void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        RealtimeChecker::checkCall ("operator delete");
+
+    std::free (pointer);
+}
+
+void operator delete[] (void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        RealtimeChecker::checkCall ("operator delete[]");
+
+    std::free (pointer);
+}
+
+#endif
+
+#endif
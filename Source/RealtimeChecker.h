@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    RealtimeChecker.h
+    Created: 18 Oct 2026 1:12:31pm
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <ostream>
+
+/**
+ Debug helper catching calls that have no place on the audio thread: memory allocation, mutexes,
+ sleeping and blocking IO.
+
+ It is only compiled in when TABBOULEH_REALTIME_CHECKS is defined to 1. processBlock then marks itself as a realtime
+ section, and RealtimeChecker.cpp intercepts the offending functions (malloc and friends, pthread locks, sleeps and
+ file IO on Linux; operator new and delete elsewhere). Any such call made while a realtime section is running on the
+ calling thread is recorded along with its stack, without allocating, and can be printed once processing is done.
+
+ Interception only works reliably in executables (the command line tools, the Standalone app), where the
+ intercepting functions take precedence over the C library's.
+ */
+class RealtimeChecker
+{
+public:
+
+    /// Marks the scope it lives in as realtime: any intercepted call made by this thread in the meantime is a violation.
+    struct ScopedRealtimeSection
+    {
+        ScopedRealtimeSection()   { ++realtimeSectionDepth; }
+        ~ScopedRealtimeSection()  { --realtimeSectionDepth; }
+    };
+
+    /// Sets up the interception. Must be called once, from the main thread, before any processing.
+    static void enable();
+
+    /// When true, the first violation prints its stack and aborts the process, handy when running under a debugger.
+    static void setAbortOnViolation (bool shouldAbort);
+
+    /// Called by the intercepting functions; records a violation if the calling thread is in a realtime section.
+    static void checkCall (const char* functionName);
+
+    /// Total number of violations so far, identical stacks included.
+    static int getNumViolations();
+
+    /// Prints every distinct violation with its symbolised stack and the number of times it happened.
+    static void printViolations (std::ostream& stream);
+
+    /// Forgets all recorded violations.
+    static void clearViolations();
+
+    static constexpr int maxDistinctViolations = 64;    // Distinct stacks kept, further ones are only counted
+    static constexpr int maxStackFrames = 32;           // Depth of the recorded stacks
+
+private:
+    static thread_local int realtimeSectionDepth;
+    static thread_local bool isRecording;
+
+    friend struct ScopedRealtimeSection;
+};
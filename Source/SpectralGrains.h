@@ -0,0 +1,316 @@
+/*
+  ==============================================================================
+
+    SpectralGrains.h
+    Created: 18 Oct 2026 9:47:21pm
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <vector>
+#include "DSPTables.h"
+
+/**
+ Grains playing in the frequency domain, from a phase vocoder analysis of the GrainBuffer.
+
+ Analysis: as the buffer is written to, a frame of its short time Fourier transform is worked out every hopSize
+ samples, and kept alongside the buffer at the position it ends at: the magnitude and phase of each bin. Every
+ spectral grain reads these same frames, nothing is analysed per grain.
+
+ Resynthesis: each grain walks through the frames at its own speed (1 plays at the original speed, 0 holds a single
+ frame, a spectral freeze), starting from the phases of its first frame and then accumulating how far the phase of every
+ bin moves from one frame to the next, as a phase vocoder does. It can be smeared by reading
+ frames around its position and jittering its phases. Once per hop the spectra of all the grains are summed, weighted
+ by the grains' left and right gains, and turned back into audio with one inverse FFT per channel, overlap-added into
+ the output. A dense cloud of spectral grains thus costs two inverse FFTs per hop, plus a pass over the bins per grain.
+
+ Every method is meant for the audio thread, and none of them allocate apart from prepare().
+ */
+class SpectralGrains
+{
+public:
+    static constexpr int fftOrder = 10;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 4;
+    static constexpr int numBins = fftSize / 2 + 1;
+    static constexpr int maxVoices = 5;
+    static constexpr int maxSmearInFrames = 16;
+
+    SpectralGrains() : fft (tables->getFFT (fftOrder)), window (tables->getHannWindow (fftSize))
+    {
+    }
+
+    /**
+     Allocates the frames for the largest buffer, and silences every grain.
+
+     @param maxBufferSize maximum size of the GrainBuffer, in samples
+     */
+    void prepare (int maxBufferSize)
+    {
+        numFrames = maxBufferSize / hopSize + 1;
+        magnitudes.assign ((size_t) (numFrames * numBins), 0.0f);
+        phases.assign ((size_t) (numFrames * numBins), 0.0f);
+
+        for (auto& voice : voices)
+            voice.phases.assign ((size_t) numBins, 0.0f);
+
+        reset();
+    }
+
+    /// Forgets the analysis and silences every grain, without allocating.
+    void reset()
+    {
+        std::fill (magnitudes.begin(), magnitudes.end(), 0.0f);
+        std::fill (phases.begin(), phases.end(), 0.0f);
+        std::fill (inputHistory.begin(), inputHistory.end(), 0.0f);
+        std::fill (outputL.begin(), outputL.end(), 0.0f);
+        std::fill (outputR.begin(), outputR.end(), 0.0f);
+        historyPosition = 0;
+        outputPosition = 0;
+        samplesToNextHop = 0;
+
+        for (auto& voice : voices)
+        {
+            voice.framePosition = 0.0f;
+            voice.gainL = 0.0f;
+            voice.gainR = 0.0f;
+        }
+    }
+
+    //==========================================================================
+    /**
+     Follows a sample written to the GrainBuffer, analysing a frame at the end of every hop.
+
+     @param position position the sample was written at
+     @param left the Left sample
+     @param right the Right sample
+     */
+    void write (int position, float left, float right)
+    {
+        inputHistory[(size_t) historyPosition] = (left + right) * 0.5f;
+        historyPosition = (historyPosition + 1) % fftSize;
+
+        if (position % hopSize == hopSize - 1)
+            analyseFrame (position / hopSize);
+    }
+
+    /**
+     Sets what the grains do, once per block.
+
+     @param _speed speed the grains walk through the frames at, 1 for the original speed and 0 to hold a frame
+     @param _smear [0-1] how far around their position the grains read, and how much their phases are jittered
+     @param readableLength number of samples of the GrainBuffer the grains can read from
+     */
+    void setParameters (float _speed, float _smear, int readableLength)
+    {
+        speed = _speed;
+        smear = _smear;
+        numReadableFrames = juce::jlimit (1, numFrames, readableLength / hopSize);
+    }
+
+    /**
+     Starts a grain, reading from the frame at a position of the buffer, with the phases found there.
+
+     @param voice index of the grain
+     @param readPosition position of the buffer the grain starts at
+     */
+    void startGrain (int voice, int readPosition)
+    {
+        auto& grain = voices[(size_t) voice];
+
+        // Frames are kept at the position they end at, so the frame centred on the position ends half an FFT later:
+        auto frame = ((readPosition + fftSize / 2) / hopSize) % numReadableFrames;
+        grain.framePosition = (float) frame;
+
+        // The first hop moves the phases from the frame before into this one:
+        auto previousFrame = frame > 0 ? frame - 1 : numReadableFrames - 1;
+        std::copy_n (phases.data() + (size_t) (previousFrame * numBins), numBins, grain.phases.data());
+    }
+
+    /**
+     Sets how loud a grain is in each channel, envelope included. Sampled once per hop.
+
+     @param voice index of the grain
+     @param left gain of the grain in the Left channel
+     @param right gain of the grain in the Right channel
+     */
+    void setGain (int voice, float left, float right)
+    {
+        voices[(size_t) voice].gainL = left;
+        voices[(size_t) voice].gainR = right;
+    }
+
+    /**
+     Returns the next output sample of every grain together, resynthesising a hop whenever the last one has been played.
+
+     @param left the Left sample is added to it
+     @param right the Right sample is added to it
+     */
+    void process (float& left, float& right)
+    {
+        if (samplesToNextHop == 0)
+        {
+            synthesiseHop();
+            samplesToNextHop = hopSize;
+        }
+
+        samplesToNextHop--;
+
+        left += outputL[(size_t) outputPosition];
+        right += outputR[(size_t) outputPosition];
+        outputL[(size_t) outputPosition] = 0.0f;
+        outputR[(size_t) outputPosition] = 0.0f;
+        outputPosition = (outputPosition + 1) % fftSize;
+    }
+
+    /// Seeds the random smearing of the grains.
+    void setRandomSeed (juce::int64 seed)
+    {
+        random.setSeed (seed);
+    }
+
+    /// Returns the delay between a grain reading a frame and the frame being heard, in samples.
+    static constexpr int getLatencyInSamples()
+    {
+        return fftSize;
+    }
+
+    //==========================================================================
+private:
+    struct Voice
+    {
+        float framePosition = 0.0f;
+        float gainL = 0.0f;
+        float gainR = 0.0f;
+        std::vector<float> phases;
+    };
+
+    juce::SharedResourcePointer<DSPTables> tables;
+    const juce::dsp::FFT& fft;
+    const std::vector<float>& window;                       // Periodic hann window, for both analysis and resynthesis
+    juce::Random random;
+
+    // Analysis:
+    std::vector<float> magnitudes;                          // numFrames frames of numBins magnitudes
+    std::vector<float> phases;                              // numFrames frames of numBins phases
+    std::array<float, fftSize> inputHistory {};
+    int historyPosition = 0;
+    int numFrames = 1;
+    int numReadableFrames = 1;
+
+    // Resynthesis:
+    std::array<Voice, maxVoices> voices;
+    std::array<float, fftSize * 2> fftData {};
+    std::array<float, fftSize * 2> spectrumL {};
+    std::array<float, fftSize * 2> spectrumR {};
+    std::array<float, fftSize> outputL {};                  // Overlap-add rings, read from outputPosition
+    std::array<float, fftSize> outputR {};
+    int outputPosition = 0;
+    int samplesToNextHop = 0;
+    float speed = 1.0f;
+    float smear = 0.0f;
+
+    /// Wraps a phase to [-pi, pi].
+    static float wrapPhase (float phase)
+    {
+        return phase - juce::MathConstants<float>::twoPi * std::round (phase / juce::MathConstants<float>::twoPi);
+    }
+
+    /// Transforms the last fftSize samples written, keeping the magnitudes and phases as the given frame.
+    void analyseFrame (int frame)
+    {
+        if (frame >= numFrames)
+            return;
+
+        for (int i=0; i<fftSize; i++)
+            fftData[(size_t) i] = inputHistory[(size_t) ((historyPosition + i) % fftSize)] * window[(size_t) i];
+
+        fft.performRealOnlyForwardTransform (fftData.data(), true);
+
+        auto* frameMagnitudes = magnitudes.data() + (size_t) (frame * numBins);
+        auto* framePhases = phases.data() + (size_t) (frame * numBins);
+
+        for (int bin = 0; bin < numBins; bin++)
+        {
+            auto real = fftData[(size_t) (2 * bin)];
+            auto imag = fftData[(size_t) (2 * bin + 1)];
+
+            frameMagnitudes[bin] = std::sqrt (real * real + imag * imag);
+            framePhases[bin] = std::atan2 (imag, real);
+        }
+    }
+
+    /// Sums the spectra of every grain, transforms them back, and overlap-adds the result into the output.
+    void synthesiseHop()
+    {
+        std::fill (spectrumL.begin(), spectrumL.end(), 0.0f);
+        std::fill (spectrumR.begin(), spectrumR.end(), 0.0f);
+        bool isAudible = false;
+
+        for (auto& voice : voices)
+        {
+            // Silent grains still walk on, so that they are where they should be when heard again:
+            if (voice.gainL > 0.0f || voice.gainR > 0.0f)
+            {
+                isAudible = true;
+                int offset = smear > 0.0f ? juce::roundToInt ((random.nextFloat() * 2.0f - 1.0f) * smear * maxSmearInFrames) : 0;
+                int frame = ((int) voice.framePosition + offset) % numReadableFrames;
+
+                if (frame < 0)
+                    frame += numReadableFrames;
+
+                // How far the phases move into the frame, from the one before it (the last one, for the first):
+                int previousFrame = frame > 0 ? frame - 1 : numReadableFrames - 1;
+                auto* frameMagnitudes = magnitudes.data() + (size_t) (frame * numBins);
+                auto* framePhases = phases.data() + (size_t) (frame * numBins);
+                auto* previousFramePhases = phases.data() + (size_t) (previousFrame * numBins);
+                auto jitter = smear * juce::MathConstants<float>::pi;
+
+                for (int bin = 0; bin < numBins; bin++)
+                {
+                    auto& phase = voice.phases[(size_t) bin];
+                    phase = wrapPhase (phase + framePhases[bin] - previousFramePhases[bin]);
+
+                    auto outputPhase = jitter > 0.0f ? phase + jitter * (random.nextFloat() * 2.0f - 1.0f) : phase;
+                    auto real = frameMagnitudes[bin] * std::cos (outputPhase);
+                    auto imag = frameMagnitudes[bin] * std::sin (outputPhase);
+
+                    spectrumL[(size_t) (2 * bin)] += voice.gainL * real;
+                    spectrumL[(size_t) (2 * bin + 1)] += voice.gainL * imag;
+                    spectrumR[(size_t) (2 * bin)] += voice.gainR * real;
+                    spectrumR[(size_t) (2 * bin + 1)] += voice.gainR * imag;
+                }
+            }
+
+            voice.framePosition += speed;
+
+            if (voice.framePosition >= (float) numReadableFrames)
+                voice.framePosition -= (float) numReadableFrames;
+        }
+
+        // A silent hop would only add zeros, skip its transforms:
+        if (! isAudible)
+            return;
+
+        // Hann windows overlapping by 3/4 add up to 1.5 once squared:
+        constexpr float overlapGain = 1.0f / 1.5f;
+
+        overlapAdd (spectrumL, outputL, overlapGain);
+        overlapAdd (spectrumR, outputR, overlapGain);
+    }
+
+    /// Transforms a spectrum back and adds it, windowed, into an output ring from its read position on.
+    void overlapAdd (std::array<float, fftSize * 2>& spectrum, std::array<float, fftSize>& output, float gain)
+    {
+        fft.performRealOnlyInverseTransform (spectrum.data());
+
+        for (int i=0; i<fftSize; i++)
+            output[(size_t) ((outputPosition + i) % fftSize)] += spectrum[(size_t) i] * window[(size_t) i] * gain;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (SpectralGrains)
+};
@@ -0,0 +1,94 @@
+/*
+  ==============================================================================
+
+    Telemetry.h
+    Created: 18 Oct 2026 7:24:45pm
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+/**
+ One thing worth showing that happened on the audio thread. Kept small and trivially copyable, so that publishing it
+ is a handful of stores.
+ */
+struct TelemetryEvent
+{
+    enum Type : juce::uint8
+    {
+        bufferWritten,          // position: write position after the block, value1: peak of the block, value2: buffer length
+        grainStarted,           // voice: grain, position: new read position, value1: grain volume
+        grainState,             // voice: grain, position: read position, value1: envelope
+        synthNoteStarted,       // voice: synth, value1: detected frequency, value2: tuned frequency, value3: volume
+        synthState              // voice: synth, value1: envelope level (0 when silent)
+    };
+
+    Type type = bufferWritten;
+    juce::uint8 voice = 0;
+    int position = 0;
+    float value1 = 0.0f;
+    float value2 = 0.0f;
+    float value3 = 0.0f;
+};
+
+/**
+ Wait-free, single producer single consumer queue of TelemetryEvents, from the audio thread to the editor.
+
+ The audio thread only ever writes into a preallocated ring through a juce::AbstractFifo: no locks, no allocation,
+ and when the editor falls behind, new events are dropped rather than waited for. Nothing is published unless an
+ editor has called setActive (true), so a closed editor costs processBlock a single relaxed load per block.
+ */
+class Telemetry
+{
+public:
+    static constexpr int capacity = 4096;
+
+    /// Called by the editor when it opens and closes.
+    void setActive (bool shouldBeActive)
+    {
+        active.store (shouldBeActive, std::memory_order_relaxed);
+    }
+
+    /// Audio thread: returns true if events should be published this block.
+    bool isActive() const
+    {
+        return active.load (std::memory_order_relaxed);
+    }
+
+    /// Audio thread: publishes an event, or drops it if the queue is full. Never blocks.
+    void push (const TelemetryEvent& event)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+        if (size1 > 0)
+            events[(size_t) start1] = event;
+
+        fifo.finishedWrite (size1);
+    }
+
+    /// Editor: hands every waiting event to the callback, in the order they were published.
+    template <typename Callback>
+    void drain (Callback&& callback)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+        for (int i=0; i<size1; i++)
+            callback (events[(size_t) (start1 + i)]);
+
+        for (int i=0; i<size2; i++)
+            callback (events[(size_t) (start2 + i)]);
+
+        fifo.finishedRead (size1 + size2);
+    }
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::array<TelemetryEvent, capacity> events;
+    std::atomic<bool> active { false };
+};
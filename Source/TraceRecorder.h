@@ -0,0 +1,249 @@
+/*
+  ==============================================================================
+
+    TraceRecorder.h
+    Created: 18 Oct 2026 5:36:12am
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+/**
+ One timestamped thing the audio thread did: a span with a duration, or an instant. Kept small and trivially copyable,
+ so that recording it is a handful of stores.
+ */
+struct TraceEvent
+{
+    enum Type : juce::uint8
+    {
+        block,                  // Span, value: samples in the block
+        idleBlock,              // Span of a block below the silence threshold, value: samples in the block
+        analysis,               // Span, voice: synth whose grain went through processFFT
+        reverb,                 // Span, value: 1 for the convolution reverb, 0 for the FDN
+        grainStarted,           // Instant, voice: grain, value: read position
+        grainSkipped,           // Instant of a grain silenced by "Bourghol", voice: grain, value: read position
+        synthTriggered          // Instant, voice: synth, value: frequency of the note
+    };
+
+    Type type = block;
+    juce::uint8 voice = 0;
+    float value = 0.0f;
+    juce::int64 startTicks = 0;             // High resolution ticks
+    juce::int64 durationTicks = -1;         // -1 for instants
+};
+
+/**
+ Records a timeline of what processBlock does, and writes it to a file in the Chrome trace event format, which
+ chrome://tracing and ui.perfetto.dev open.
+
+ The audio thread only writes TraceEvents into a preallocated ring through a juce::AbstractFifo: no locks, no
+ allocation, and events are dropped and counted when the writer falls behind. A background thread empties the ring
+ into the file a few times a second. Nothing is recorded unless start() was called, so a recorder that isn't recording
+ costs processBlock a single relaxed load per block.
+
+ start() and stop() are called from one thread, such as the message thread.
+ */
+class TraceRecorder : private juce::Thread
+{
+public:
+    static constexpr int capacity = 1 << 16;
+
+    TraceRecorder() : juce::Thread ("Tabbouleh trace writer"), events ((size_t) capacity)
+    {
+    }
+
+    ~TraceRecorder() override
+    {
+        stop();
+    }
+
+    /**
+     Starts recording into a file, replacing it, after stopping any recording in progress.
+
+     @param file file the trace is written to, usually with a .json extension
+     @return false if the file can't be written to
+     */
+    bool start (const juce::File& file)
+    {
+        stop();
+        file.deleteFile();
+
+        auto output = std::make_unique<juce::FileOutputStream> (file);
+
+        if (output->failedToOpen())
+            return false;
+
+        stream = std::move (output);
+        traceFile = file;
+        traceStartTicks = juce::Time::getHighResolutionTicks();
+        numDropped.store (0, std::memory_order_relaxed);
+
+        *stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+                << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Tabbouleh\"}},\n"
+                << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Audio thread\"}}";
+
+        recording.store (true, std::memory_order_release);
+        startThread();
+        return true;
+    }
+
+    /// Stops recording, writes what is left in the ring and closes the file.
+    void stop()
+    {
+        if (stream == nullptr)
+            return;
+
+        recording.store (false, std::memory_order_release);
+        stopThread (2000);
+        writeWaitingEvents();
+
+        *stream << "\n],\"otherData\":{\"droppedEvents\":" << juce::String (getNumDropped()) << "}}\n";
+        stream->flush();
+        stream.reset();
+    }
+
+    /// Audio thread: returns true if events should be recorded this block.
+    bool isRecording() const
+    {
+        return recording.load (std::memory_order_relaxed);
+    }
+
+    /// The file of the last recording.
+    juce::File getFile() const  { return traceFile; }
+
+    /// Events dropped by the last recording, because the ring was full.
+    juce::int64 getNumDropped() const  { return numDropped.load (std::memory_order_relaxed); }
+
+    //==========================================================================
+    /// Audio thread: the time now, to start a span with.
+    static juce::int64 now()
+    {
+        return juce::Time::getHighResolutionTicks();
+    }
+
+    /// Audio thread: records a span from the given start until now.
+    void addSpan (TraceEvent::Type type, juce::int64 startTicks, int voice = 0, float value = 0.0f)
+    {
+        auto endTicks = now();
+        push ({ type, (juce::uint8) voice, value, startTicks, endTicks - startTicks });
+    }
+
+    /// Audio thread: records an instant, now.
+    void addInstant (TraceEvent::Type type, int voice = 0, float value = 0.0f)
+    {
+        push ({ type, (juce::uint8) voice, value, now(), -1 });
+    }
+
+    //==========================================================================
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::vector<TraceEvent> events;
+    std::atomic<bool> recording { false };
+    std::atomic<juce::int64> numDropped { 0 };
+
+    // Only used by the writer:
+    std::unique_ptr<juce::FileOutputStream> stream;
+    juce::File traceFile;
+    juce::int64 traceStartTicks = 0;
+
+    /// Audio thread: records an event, or drops it if the ring is full. Never blocks.
+    void push (const TraceEvent& event)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+        if (size1 > 0)
+            events[(size_t) start1] = event;
+        else
+            numDropped.store (numDropped.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        fifo.finishedWrite (size1);
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            writeWaitingEvents();
+            wait (100);
+        }
+    }
+
+    /// Empties the ring into the file.
+    void writeWaitingEvents()
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+        for (int i=0; i<size1; i++)
+            writeEvent (events[(size_t) (start1 + i)]);
+
+        for (int i=0; i<size2; i++)
+            writeEvent (events[(size_t) (start2 + i)]);
+
+        fifo.finishedRead (size1 + size2);
+    }
+
+    /// Microseconds since the start of the recording, as the trace format counts time.
+    double toMicroseconds (juce::int64 ticks) const
+    {
+        return juce::Time::highResolutionTicksToSeconds (ticks) * 1.0e6;
+    }
+
+    void writeEvent (const TraceEvent& event)
+    {
+        // A block still running when the last recording stopped may have left some events behind:
+        if (event.startTicks < traceStartTicks)
+            return;
+
+        juce::String name, arguments;
+
+        switch (event.type)
+        {
+            case TraceEvent::block:
+                name = "processBlock";
+                arguments = "\"samples\":" + juce::String ((int) event.value);
+                break;
+
+            case TraceEvent::idleBlock:
+                name = "processBlock (idle)";
+                arguments = "\"samples\":" + juce::String ((int) event.value);
+                break;
+
+            case TraceEvent::analysis:
+                name = "analysis";
+                arguments = "\"synth\":" + juce::String (event.voice);
+                break;
+
+            case TraceEvent::reverb:
+                name = event.value > 0.5f ? "convolution reverb" : "reverb";
+                break;
+
+            case TraceEvent::grainStarted:
+            case TraceEvent::grainSkipped:
+                name = event.type == TraceEvent::grainStarted ? "grain start" : "grain skip";
+                arguments = "\"grain\":" + juce::String (event.voice) + ",\"position\":" + juce::String ((int) event.value);
+                break;
+
+            case TraceEvent::synthTriggered:
+                name = "synth note";
+                arguments = "\"synth\":" + juce::String (event.voice) + ",\"frequency\":" + juce::String (event.value, 2);
+                break;
+        }
+
+        juce::String line (",\n{\"name\":\"" + name + "\",\"pid\":1,\"tid\":1,\"ts\":"
+                           + juce::String (toMicroseconds (event.startTicks - traceStartTicks), 3));
+
+        if (event.durationTicks >= 0)
+            line += ",\"ph\":\"X\",\"dur\":" + juce::String (toMicroseconds (event.durationTicks), 3);
+        else
+            line += ",\"ph\":\"i\",\"s\":\"t\"";
+
+        line += ",\"args\":{" + arguments + "}}";
+        *stream << line;
+    }
+};
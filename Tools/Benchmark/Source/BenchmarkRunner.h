@@ -0,0 +1,190 @@
+/*
+  ==============================================================================
+
+    BenchmarkRunner.h
+    Created: 18 Oct 2026 11:42:50am
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <chrono>
+
+#if defined (__x86_64__) || defined (__i386__)
+ #include <x86intrin.h>
+ #define TABBOULEH_HAS_CYCLE_COUNTER 1
+#elif defined (_M_X64) || defined (_M_IX86)
+ #include <intrin.h>
+ #define TABBOULEH_HAS_CYCLE_COUNTER 1
+#else
+ #define TABBOULEH_HAS_CYCLE_COUNTER 0
+#endif
+
+/// Reads the time stamp counter, or returns 0 on platforms without one.
+inline juce::uint64 readCycleCounter()
+{
+   #if TABBOULEH_HAS_CYCLE_COUNTER
+    return (juce::uint64) __rdtsc();
+   #else
+    return 0;
+   #endif
+}
+
+/// One measurement: the cost of a single unit of work ("sample", "call"...) for a benchmark at one point of a sweep.
+struct BenchmarkResult
+{
+    juce::String name;                      // What was measured, e.g. "Grain::process"
+    juce::String parameter;                 // Swept parameter, empty if there is none
+    double parameterValue = 0.0;            // Value of the swept parameter
+    juce::String unit;                      // What a unit of work is
+    double cyclesPerUnit = 0.0;             // Median over all runs, 0 if there is no cycle counter
+    double nanosecondsPerUnit = 0.0;        // Median over all runs
+    juce::int64 unitsPerRun = 0;
+
+    juce::var toVar() const
+    {
+        auto* object = new juce::DynamicObject();
+        object->setProperty ("name", name);
+        object->setProperty ("parameter", parameter);
+        object->setProperty ("parameterValue", parameterValue);
+        object->setProperty ("unit", unit);
+        object->setProperty ("cyclesPerUnit", cyclesPerUnit);
+        object->setProperty ("nanosecondsPerUnit", nanosecondsPerUnit);
+        object->setProperty ("unitsPerRun", unitsPerRun);
+        return juce::var (object);
+    }
+};
+
+/**
+ Times pieces of work and collects the results.
+
+ Each benchmark is run once to warm up, then a number of times in a row; the median of those runs is kept,
+ which makes the figures robust against the odd interruption by the system.
+ */
+class BenchmarkRunner
+{
+public:
+
+    /**
+     @param _numRuns number of timed runs per benchmark
+     @param _filter only benchmarks whose name contains this string are run, empty to run everything
+     */
+    BenchmarkRunner (int _numRuns, const juce::String& _filter)
+        : numRuns (juce::jmax (1, _numRuns)), filter (_filter)
+    {
+    }
+
+    /// Returns true if the named benchmark passes the filter. Use to skip expensive setup.
+    bool isEnabled (const juce::String& name) const
+    {
+        return filter.isEmpty() || name.containsIgnoreCase (filter);
+    }
+
+    /**
+     Times a benchmark.
+
+     @param name what is being measured
+     @param parameter name of the swept parameter, empty if there is none
+     @param parameterValue value of the swept parameter
+     @param unit what a unit of work is, e.g. "sample"
+     @param unitsPerRun how many units of work a single call of body performs
+     @param body callable running one full run; it must return a float derived from its work so it can't be optimised away
+     */
+    template <typename Callable>
+    void run (const juce::String& name, const juce::String& parameter, double parameterValue,
+              const juce::String& unit, juce::int64 unitsPerRun, Callable&& body)
+    {
+        if (! isEnabled (name))
+            return;
+
+        std::vector<double> cycles, nanoseconds;
+
+        for (int run = -1; run < numRuns; run++)
+        {
+            auto startTime = std::chrono::steady_clock::now();
+            auto startCycles = readCycleCounter();
+
+            sink = sink + body();
+
+            auto endCycles = readCycleCounter();
+            auto endTime = std::chrono::steady_clock::now();
+
+            // Run -1 is the warm up:
+            if (run < 0)
+                continue;
+
+            cycles.push_back (double (endCycles - startCycles) / double (unitsPerRun));
+            nanoseconds.push_back (std::chrono::duration<double, std::nano> (endTime - startTime).count() / double (unitsPerRun));
+        }
+
+        BenchmarkResult result;
+        result.name = name;
+        result.parameter = parameter;
+        result.parameterValue = parameterValue;
+        result.unit = unit;
+        result.cyclesPerUnit = median (cycles);
+        result.nanosecondsPerUnit = median (nanoseconds);
+        result.unitsPerRun = unitsPerRun;
+        addResult (result);
+    }
+
+    /// Records a result measured by the caller, for work that can't be timed as a whole run.
+    void addResult (const BenchmarkResult& result)
+    {
+        results.push_back (result);
+        print (result);
+    }
+
+    const std::vector<BenchmarkResult>& getResults() const
+    {
+        return results;
+    }
+
+    /// Writes every result collected so far, along with a description of the machine, as JSON.
+    bool writeJson (const juce::File& file, double sampleRate) const
+    {
+        juce::var resultList;
+
+        for (auto& result : results)
+            resultList.append (result.toVar());
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty ("cpu", juce::SystemStats::getCpuModel());
+        root->setProperty ("numCpus", juce::SystemStats::getNumCpus());
+        root->setProperty ("os", juce::SystemStats::getOperatingSystemName());
+        root->setProperty ("date", juce::Time::getCurrentTime().toISO8601 (true));
+        root->setProperty ("sampleRate", sampleRate);
+        root->setProperty ("runs", numRuns);
+        root->setProperty ("hasCycleCounter", TABBOULEH_HAS_CYCLE_COUNTER != 0);
+        root->setProperty ("results", resultList);
+
+        return file.replaceWithText (juce::JSON::toString (juce::var (root)));
+    }
+
+    static double median (std::vector<double> values)
+    {
+        std::sort (values.begin(), values.end());
+        return values[values.size() / 2];
+    }
+
+private:
+    int numRuns;
+    juce::String filter;
+    std::vector<BenchmarkResult> results;
+    volatile float sink = 0.0f;             // Receives the output of every run, so that no work is optimised away
+
+    static void print (const BenchmarkResult& result)
+    {
+        auto label = result.name;
+
+        if (result.parameter.isNotEmpty())
+            label += " [" + result.parameter + " = " + juce::String (result.parameterValue) + "]";
+
+        std::cout << label.paddedRight (' ', 60)
+                  << juce::String (result.cyclesPerUnit, 1).paddedLeft (' ', 12) << " cycles/" << result.unit
+                  << juce::String (result.nanosecondsPerUnit, 2).paddedLeft (' ', 12) << " ns/" << result.unit
+                  << std::endl;
+    }
+};
@@ -0,0 +1,635 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 18 Oct 2026 11:37:24am
+
+    Microbenchmarks for the building blocks of the engine and for the whole
+    processBlock, with sweeps over grain length, grain count and block size.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+#include "BenchmarkRunner.h"
+
+static const char* usage =
+    "Usage: TabboulehBenchmark [options]\n"
+    "\n"
+    "Options:\n"
+    "  --json=<file>               write the results as JSON\n"
+    "  --filter=<text>             only run benchmarks whose name contains the text\n"
+    "  --runs=<count>              timed runs per benchmark, the median is kept (default: 5)\n"
+    "  --seconds=<seconds>         audio processed per run (default: 2)\n"
+    "  --sample-rate=<hz>          sample rate (default: 48000)\n"
+    "\n"
+    "State benchmarks compare the binary format (format=1) with the older XML one (format=0).\n";
+
+//==============================================================================
+/// Fills a buffer with a deterministic test signal: a few harmonics over some noise.
+static void fillTestSignal (float* destination, int numSamples, double sampleRate)
+{
+    juce::Random random (1234);
+
+    for (int i=0; i<numSamples; i++)
+    {
+        auto t = i / sampleRate;
+        destination[i] = 0.3f * (float) std::sin (juce::MathConstants<double>::twoPi * 220.0 * t)
+                       + 0.1f * (float) std::sin (juce::MathConstants<double>::twoPi * 660.0 * t)
+                       + 0.05f * (random.nextFloat() - 0.5f);
+    }
+}
+
+/// Sets a parameter of the processor from its real (not normalised) value.
+static void setParameter (juce::AudioProcessor& processor, const juce::String& parameterID, float value)
+{
+    for (auto* parameter : processor.getParameters())
+    {
+        if (auto* rangedParameter = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+        {
+            if (rangedParameter->paramID == parameterID)
+                rangedParameter->setValueNotifyingHost (rangedParameter->convertTo0to1 (value));
+        }
+    }
+}
+
+//==============================================================================
+template <typename OscillatorType>
+static void benchmarkOscillator (BenchmarkRunner& runner, const juce::String& name, double sampleRate, int numSamples)
+{
+    OscillatorType oscillator;
+    oscillator.setSampleRate ((float) sampleRate);
+    oscillator.setFrequency (441.0f);
+
+    runner.run (name + "::process", {}, 0.0, "sample", numSamples, [&]
+    {
+        float sum = 0.0f;
+
+        for (int i=0; i<numSamples; i++)
+            sum += oscillator.process();
+
+        return sum;
+    });
+}
+
+static void benchmarkOscillators (BenchmarkRunner& runner, double sampleRate, int numSamples)
+{
+    benchmarkOscillator<Phasor>               (runner, "Phasor", sampleRate, numSamples);
+    benchmarkOscillator<TriRamp>              (runner, "TriRamp", sampleRate, numSamples);
+    benchmarkOscillator<TriOsc>               (runner, "TriOsc", sampleRate, numSamples);
+    benchmarkOscillator<SineOsc>              (runner, "SineOsc", sampleRate, numSamples);
+    benchmarkOscillator<HardSquareOsc>        (runner, "HardSquareOsc", sampleRate, numSamples);
+    benchmarkOscillator<SoftSquareOsc>        (runner, "SoftSquareOsc", sampleRate, numSamples);
+    benchmarkOscillator<SawToothOsc>          (runner, "SawToothOsc", sampleRate, numSamples);
+    benchmarkOscillator<AntiAliasSawToothOsc> (runner, "AntiAliasSawToothOsc", sampleRate, numSamples);
+}
+
+//==============================================================================
+/**
+ Prints the signal to noise ratio of the half float history at a few levels of the test signal: what is read back
+ from the buffer against what was written.
+ */
+static void printHistoryNoiseFloor (double sampleRate, int numSamples)
+{
+    std::vector<float> input ((size_t) numSamples);
+    fillTestSignal (input.data(), numSamples, sampleRate);
+
+    GrainBuffer grainBuffer;
+    grainBuffer.initialise (5, (int) sampleRate, GrainBuffer::Storage::float16);
+    grainBuffer.setBufferSize (4.99f);
+
+    std::cout << "History noise floor (float16, " << HalfFloat::getConversionName() << " conversions):";
+
+    for (auto levelInDecibels : { 0.0f, -20.0f, -40.0f, -60.0f, -80.0f })
+    {
+        auto gain = juce::Decibels::decibelsToGain (levelInDecibels);
+        double signalEnergy = 0.0, noiseEnergy = 0.0;
+
+        for (int i=0; i<numSamples; i++)
+        {
+            auto sample = input[(size_t) i] * gain;
+            grainBuffer.writeVal (sample, sample);
+
+            auto error = (double) grainBuffer.readValL (grainBuffer.getWritePos()) - sample;
+            signalEnergy += (double) sample * sample;
+            noiseEnergy += error * error;
+        }
+
+        std::cout << " " << levelInDecibels << " dB: " << juce::String (10.0 * std::log10 (signalEnergy / std::max (noiseEnergy, 1.0e-30)), 1) << " dB SNR,";
+    }
+
+    std::cout << std::endl;
+}
+
+static void benchmarkGrainBuffer (BenchmarkRunner& runner, double sampleRate, int numSamples)
+{
+    if (runner.isEnabled ("GrainBuffer"))
+        printHistoryNoiseFloor (sampleRate, numSamples);
+
+    std::vector<float> input ((size_t) numSamples);
+    fillTestSignal (input.data(), numSamples, sampleRate);
+
+    // Random reads, as done by grains jumping around the buffer:
+    std::vector<int> readPositions ((size_t) numSamples);
+    juce::Random random (42);
+
+    for (auto& position : readPositions)
+        position = random.nextInt ((int) (5.0 * sampleRate));
+
+    // Each storage, labelled with its bits per sample:
+    for (auto storage : { GrainBuffer::Storage::float32, GrainBuffer::Storage::float16 })
+    {
+        GrainBuffer grainBuffer;
+        grainBuffer.initialise (5, (int) sampleRate, storage);
+        grainBuffer.setBufferSize (2.0f);
+        auto bits = storage == GrainBuffer::Storage::float16 ? 16 : 32;
+
+        runner.run ("GrainBuffer::writeVal", "storage", bits, "sample", numSamples, [&]
+        {
+            for (int i=0; i<numSamples; i++)
+                grainBuffer.writeVal (input[(size_t) i], input[(size_t) i]);
+
+            return grainBuffer.readValL (0);
+        });
+
+        runner.run ("GrainBuffer::readValL (random)", "storage", bits, "sample", numSamples, [&]
+        {
+            float sum = 0.0f;
+
+            for (int i=0; i<numSamples; i++)
+                sum += grainBuffer.readValL (readPositions[(size_t) i]);
+
+            return sum;
+        });
+
+        // Sequential reads, as done by a single grain:
+        runner.run ("GrainBuffer::readValL (sequential)", "storage", bits, "sample", numSamples, [&]
+        {
+            float sum = 0.0f;
+            int maxReadPos = (int) grainBuffer.getMaxReadPos();
+
+            for (int i=0; i<numSamples; i++)
+                sum += grainBuffer.readValL (i % maxReadPos);
+
+            return sum;
+        });
+    }
+}
+
+//==============================================================================
+static const float grainLengths[] = { 0.02f, 0.05f, 0.1f, 0.5f, 2.0f };
+
+static void benchmarkGrain (BenchmarkRunner& runner, double sampleRate, int numSamples)
+{
+    for (auto grainLength : grainLengths)
+    {
+        Grain grain ((int) sampleRate, 0.0f, grainLength);
+
+        runner.run ("Grain::process", "grain_Length", grainLength, "sample", numSamples, [&]
+        {
+            float sum = 0.0f;
+
+            for (int i=0; i<numSamples; i++)
+            {
+                grain.process (grainLength, (int) (2.0 * sampleRate), 0.3f, 0.6f, 0.05f, 0.2f);
+                sum += grain.getStereoVolumeLeft();
+            }
+
+            return sum;
+        });
+    }
+}
+
+//==============================================================================
+static void benchmarkFFTSynth (BenchmarkRunner& runner, double sampleRate, int numSamples)
+{
+    std::vector<float> input ((size_t) numSamples);
+    fillTestSignal (input.data(), numSamples, sampleRate);
+
+    // writeInSamples at the rate of each grain length, analyses included:
+    for (auto grainLength : grainLengths)
+    {
+        if (! runner.isEnabled ("FFTSynth::writeInSamples"))
+            break;
+
+        auto fftSynth = std::make_unique<FFTSynth> ((int) sampleRate, 0.5f, grainLength, 0.6f, 440.0f);
+        auto grainLengthInSamples = (int) (grainLength * sampleRate);
+
+        runner.run ("FFTSynth::writeInSamples", "grain_Length", grainLength, "sample", numSamples, [&]
+        {
+            float sum = 0.0f;
+
+            for (int i=0; i<numSamples; i++)
+            {
+                fftSynth->writeInSamples (input[(size_t) i], input[(size_t) i], i % grainLengthInSamples == 0, 0.01f, 0.0f, 0.2f);
+                sum += fftSynth->processSynth (2.0f);
+            }
+
+            return sum;
+        });
+    }
+
+    // processFFT is private, and runs from writeInSamples at the start of a grain when the previous one was
+    // loud enough; time that call alone, after a full analysis window has been captured each time.
+    if (runner.isEnabled ("FFTSynth::processFFT"))
+    {
+        auto fftSynth = std::make_unique<FFTSynth> ((int) sampleRate, 0.5f, 0.1f, 0.6f, 440.0f);
+        auto windowLength = (int) (0.02 * sampleRate);
+        std::vector<double> cycles, nanoseconds;
+
+        for (int analysis = -1; analysis < 64; analysis++)
+        {
+            for (int i=0; i<windowLength; i++)
+                fftSynth->writeInSamples (input[(size_t) i], input[(size_t) i], i == 0, 0.01f, 0.0f, 0.2f);
+
+            auto startTime = std::chrono::steady_clock::now();
+            auto startCycles = readCycleCounter();
+
+            fftSynth->writeInSamples (input[0], input[0], true, 0.01f, 0.0f, 0.2f);
+
+            auto endCycles = readCycleCounter();
+            auto endTime = std::chrono::steady_clock::now();
+
+            // Analysis -1 is the warm up:
+            if (analysis < 0)
+                continue;
+
+            cycles.push_back (double (endCycles - startCycles));
+            nanoseconds.push_back (std::chrono::duration<double, std::nano> (endTime - startTime).count());
+        }
+
+        BenchmarkResult result;
+        result.name = "FFTSynth::processFFT";
+        result.unit = "call";
+        result.cyclesPerUnit = BenchmarkRunner::median (cycles);
+        result.nanosecondsPerUnit = BenchmarkRunner::median (nanoseconds);
+        result.unitsPerRun = 1;
+        runner.addResult (result);
+    }
+}
+
+//==============================================================================
+/**
+ The per-sample loop over the voices, as renderVoices runs it: each grain, then the synth it feeds. The voices live
+ side by side in vectors as in the processor, so the span they cover shows how many cache lines and pages each sample
+ touches.
+ */
+static void benchmarkVoices (BenchmarkRunner& runner, double sampleRate, int numSamples)
+{
+    if (! runner.isEnabled ("Voices::process"))
+        return;
+
+    std::vector<float> input ((size_t) numSamples);
+    fillTestSignal (input.data(), numSamples, sampleRate);
+
+    std::vector<Grain> grains;
+    std::vector<FFTSynth> fftSynths;
+
+    for (int i=0; i<5; i++)
+    {
+        grains.push_back (Grain ((int) sampleRate, i * 0.2f, 0.1f));
+        fftSynths.push_back (FFTSynth ((int) sampleRate, 0.5f, 0.1f, 0.6f, 440.0f));
+    }
+
+    // Bytes from the first voice to the end of the last one:
+    auto grainSpan = (size_t) ((const char*) (grains.data() + grains.size()) - (const char*) grains.data());
+    auto synthSpan = (size_t) ((const char*) (fftSynths.data() + fftSynths.size()) - (const char*) fftSynths.data());
+
+    std::cout << "Voice layout: sizeof (Grain) = " << sizeof (Grain) << ", sizeof (FFTSynth) = " << sizeof (FFTSynth)
+              << ", 5 voices span " << grainSpan + synthSpan << " bytes (" << (grainSpan + synthSpan + 4095) / 4096 << " pages)" << std::endl;
+
+    for (int numVoices = 1; numVoices <= 5; numVoices++)
+    {
+        runner.run ("Voices::process", "active_Grains", numVoices, "sample", numSamples, [&]
+        {
+            float sum = 0.0f;
+
+            for (int i=0; i<numSamples; i++)
+            {
+                for (int voice = 0; voice < numVoices; voice++)
+                {
+                    auto& grain = grains[(size_t) voice];
+                    auto& fftSynth = fftSynths[(size_t) voice];
+
+                    grain.process (0.1f, (int) (2.0 * sampleRate), 0.3f, 0.6f, 0.0f, 0.2f);
+                    auto sample = input[(size_t) i] * grain.getSampleEnvelope();
+                    fftSynth.writeInSamples (sample, sample, grain.newGrainStarted(), 0.01f, 0.0f, 0.2f);
+                    sum += sample * grain.getStereoVolumeLeft() + fftSynth.processSynth (2.0f) * fftSynth.getStereoVolumeLeft();
+                }
+            }
+
+            return sum;
+        });
+    }
+}
+
+//==============================================================================
+/// Five grains through their own low pass, one MyFilter per grain and channel against the GrainFilterBank.
+static void benchmarkGrainFilters (BenchmarkRunner& runner, double sampleRate, int numSamples)
+{
+    std::vector<float> input ((size_t) numSamples);
+    fillTestSignal (input.data(), numSamples, sampleRate);
+
+    std::vector<MyFilter> filters;
+
+    for (int i=0; i<10; i++)
+    {
+        filters.push_back (MyFilter ((float) sampleRate, 500.0f + 400.0f * i, 2.0f));
+        filters.back().setDryWet (0.0f, 1.0f);
+    }
+
+    runner.run ("MyFilter::processLPFSample", "grains", 5, "sample", numSamples, [&]
+    {
+        float sum = 0.0f;
+
+        for (int i=0; i<numSamples; i++)
+            for (int grain = 0; grain < 5; grain++)
+                sum += filters[(size_t) grain].processLPFSample (input[(size_t) i])
+                     + filters[(size_t) (5 + grain)].processLPFSample (input[(size_t) i]);
+
+        return sum;
+    });
+
+    GrainFilterBank filterBank;
+    filterBank.prepare (sampleRate);
+    filterBank.setParameters (2000.0f, 2.0f, 0.5f);
+
+    for (int grain = 0; grain < 5; grain++)
+        filterBank.startGrain (grain);
+
+    runner.run ("GrainFilterBank::process", "grains", 5, "sample", numSamples, [&]
+    {
+        float left = 0.0f, right = 0.0f;
+
+        for (int i=0; i<numSamples; i++)
+        {
+            for (int grain = 0; grain < 5; grain++)
+                filterBank.setInput (grain, input[(size_t) i], input[(size_t) i]);
+
+            filterBank.process (left, right);
+        }
+
+        return left + right;
+    });
+}
+
+//==============================================================================
+static void benchmarkReverbs (BenchmarkRunner& runner, double sampleRate, int numSamples)
+{
+    std::vector<float> inputL ((size_t) numSamples), inputR ((size_t) numSamples);
+    fillTestSignal (inputL.data(), numSamples, sampleRate);
+    fillTestSignal (inputR.data(), numSamples, sampleRate);
+    std::vector<float> left ((size_t) numSamples), right ((size_t) numSamples);
+
+    // The comb and all-pass network "Oil" used to drive:
+    juce::Reverb juceReverb;
+    juceReverb.setSampleRate (sampleRate);
+
+    runner.run ("juce::Reverb::processStereo", {}, 0.0, "sample", numSamples, [&]
+    {
+        std::copy (inputL.begin(), inputL.end(), left.begin());
+        std::copy (inputR.begin(), inputR.end(), right.begin());
+        juceReverb.processStereo (left.data(), right.data(), numSamples);
+        return left.back();
+    });
+
+    for (auto quality : { FDNReverb::Quality::economy, FDNReverb::Quality::lush })
+    {
+        FDNReverb reverb;
+        reverb.setQuality (quality);
+        reverb.prepare (sampleRate);
+        auto name = juce::String ("FDNReverb::processSend") + (quality == FDNReverb::Quality::lush ? " (lush)" : " (economy)");
+
+        runner.run (name, {}, 0.0, "sample", numSamples, [&]
+        {
+            reverb.processSend (inputL.data(), inputR.data(), left.data(), right.data(), numSamples);
+            return left.back();
+        });
+    }
+}
+
+//==============================================================================
+/// Builds the XML state written before BinaryState existed, as AudioProcessorValueTreeState::copyState() laid it out.
+static void writeLegacyXmlState (juce::AudioProcessor& processor, juce::MemoryBlock& destData)
+{
+    juce::XmlElement xml ("ParameterTree");
+
+    for (auto* parameter : processor.getParameters())
+    {
+        if (auto* rangedParameter = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+        {
+            auto* child = xml.createNewChildElement ("PARAM");
+            child->setAttribute ("id", rangedParameter->paramID);
+            child->setAttribute ("value", rangedParameter->convertFrom0to1 (rangedParameter->getValue()));
+        }
+    }
+
+    destData.reset();
+    juce::AudioProcessor::copyXmlToBinary (xml, destData);
+}
+
+static void benchmarkState (BenchmarkRunner& runner)
+{
+    TabboulehAudioProcessor processor;
+    constexpr int numRepeats = 1000;
+
+    juce::MemoryBlock binaryState, xmlState;
+    processor.getStateInformation (binaryState);
+    writeLegacyXmlState (processor, xmlState);
+
+    runner.run ("TabboulehAudioProcessor::getStateInformation", "format", 1.0, "instance", numRepeats, [&]
+    {
+        for (int i=0; i<numRepeats; i++)
+            processor.getStateInformation (binaryState);
+
+        return (float) binaryState.getSize();
+    });
+
+    runner.run ("TabboulehAudioProcessor::getStateInformation", "format", 0.0, "instance", numRepeats, [&]
+    {
+        for (int i=0; i<numRepeats; i++)
+            writeLegacyXmlState (processor, xmlState);
+
+        return (float) xmlState.getSize();
+    });
+
+    // Alternate between two settings, so that every load has parameters to change:
+    juce::MemoryBlock otherBinaryState, otherXmlState;
+    setParameter (processor, "grain_Length", 0.5f);
+    setParameter (processor, "reverb_Amount", 0.8f);
+    processor.getStateInformation (otherBinaryState);
+    writeLegacyXmlState (processor, otherXmlState);
+
+    runner.run ("TabboulehAudioProcessor::setStateInformation", "format", 1.0, "instance", numRepeats, [&]
+    {
+        for (int i=0; i<numRepeats; i++)
+        {
+            auto& state = i % 2 == 0 ? binaryState : otherBinaryState;
+            processor.setStateInformation (state.getData(), (int) state.getSize());
+        }
+
+        return processor.getParameters()[0]->getValue();
+    });
+
+    runner.run ("TabboulehAudioProcessor::setStateInformation", "format", 0.0, "instance", numRepeats, [&]
+    {
+        for (int i=0; i<numRepeats; i++)
+        {
+            auto& state = i % 2 == 0 ? xmlState : otherXmlState;
+            processor.setStateInformation (state.getData(), (int) state.getSize());
+        }
+
+        return processor.getParameters()[0]->getValue();
+    });
+}
+
+/// Times making and preparing instances while another one already holds the shared DSP tables, as when a session loads.
+static void benchmarkInstances (BenchmarkRunner& runner, double sampleRate)
+{
+    if (! runner.isEnabled ("TabboulehAudioProcessor::prepareToPlay"))
+        return;
+
+    constexpr int numInstances = 16;
+    TabboulehAudioProcessor firstInstance;
+    firstInstance.setPlayConfigDetails (2, 2, sampleRate, 512);
+    firstInstance.prepareToPlay (sampleRate, 512);
+
+    runner.run ("TabboulehAudioProcessor::prepareToPlay", "instances", numInstances, "instance", numInstances, [&]
+    {
+        std::vector<std::unique_ptr<TabboulehAudioProcessor>> instances;
+
+        for (int i=0; i<numInstances; i++)
+        {
+            instances.push_back (std::make_unique<TabboulehAudioProcessor>());
+            instances.back()->setPlayConfigDetails (2, 2, sampleRate, 512);
+            instances.back()->prepareToPlay (sampleRate, 512);
+        }
+
+        return (float) instances.size();
+    });
+
+    std::cout << "Shared DSP tables: " << juce::SharedResourcePointer<DSPTables>()->getNumTables()
+              << ", the same for any number of instances" << std::endl;
+}
+
+//==============================================================================
+static void benchmarkProcessBlock (BenchmarkRunner& runner, double sampleRate, int numSamples,
+                                   const juce::String& parameter, double parameterValue,
+                                   int blockSize, float grainLength, float activeGrains, bool frozen = false,
+                                   const juce::String& silencedParameterID = {})
+{
+    TabboulehAudioProcessor processor;
+    processor.setPlayConfigDetails (2, 2, sampleRate, blockSize);
+    setParameter (processor, "grain_Length", grainLength);
+    setParameter (processor, "active_Grains", activeGrains);
+
+    if (silencedParameterID.isNotEmpty())
+        setParameter (processor, silencedParameterID, 0.0f);
+    processor.prepareToPlay (sampleRate, blockSize);
+    processor.getQualityGovernor().setEnabled (false);      // Always measure full quality
+
+    std::vector<float> input ((size_t) numSamples);
+    fillTestSignal (input.data(), numSamples, sampleRate);
+
+    juce::AudioBuffer<float> buffer (2, blockSize);
+    juce::MidiBuffer midiMessages;
+    auto numBlocks = numSamples / blockSize;
+
+    if (frozen)
+    {
+        // Fill the buffer, then freeze it, letting the first frozen block run the analysis in place of the background thread:
+        for (int block = 0; block < numBlocks; block++)
+        {
+            buffer.copyFrom (0, 0, input.data() + block * blockSize, blockSize);
+            buffer.copyFrom (1, 0, input.data() + block * blockSize, blockSize);
+            processor.processBlock (buffer, midiMessages);
+        }
+
+        setParameter (processor, "freeze", 1.0f);
+        processor.setNonRealtime (true);
+        processor.processBlock (buffer, midiMessages);
+    }
+
+    runner.run ("TabboulehAudioProcessor::processBlock", parameter, parameterValue, "sample", (juce::int64) numBlocks * blockSize, [&]
+    {
+        float sum = 0.0f;
+
+        for (int block = 0; block < numBlocks; block++)
+        {
+            buffer.copyFrom (0, 0, input.data() + block * blockSize, blockSize);
+            buffer.copyFrom (1, 0, input.data() + block * blockSize, blockSize);
+            processor.processBlock (buffer, midiMessages);
+            sum += buffer.getSample (0, 0);
+        }
+
+        return sum;
+    });
+}
+
+static void benchmarkProcessor (BenchmarkRunner& runner, double sampleRate, int numSamples)
+{
+    if (! runner.isEnabled ("TabboulehAudioProcessor::processBlock"))
+        return;
+
+    // Each sweep moves one parameter away from the defaults (512 samples, 0.1 s grains, Onion at 2):
+    for (auto blockSize : { 32, 64, 128, 256, 512, 1024, 2048 })
+        benchmarkProcessBlock (runner, sampleRate, numSamples, "block_Size", blockSize, blockSize, 0.1f, 2.0f);
+
+    for (auto grainLength : grainLengths)
+        benchmarkProcessBlock (runner, sampleRate, numSamples, "grain_Length", grainLength, 512, grainLength, 2.0f);
+
+    for (auto activeGrains : { 1.0f, 2.0f, 3.0f, 4.0f, 4.99f })
+        benchmarkProcessBlock (runner, sampleRate, numSamples, "active_Grains", activeGrains, 512, 0.1f, activeGrains);
+
+    for (auto frozen : { false, true })
+        benchmarkProcessBlock (runner, sampleRate, numSamples, "freeze", frozen ? 1.0 : 0.0, 512, 0.1f, 2.0f, frozen);
+
+    // Each section turned down to 0, which should take its share of the time off the defaults:
+    for (auto* silencedParameterID : { "synth_Volume", "grain_Volume", "reverb_Amount" })
+        benchmarkProcessBlock (runner, sampleRate, numSamples, silencedParameterID, 0.0, 512, 0.1f, 2.0f, false, silencedParameterID);
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList arguments (argc, argv);
+
+    if (arguments.containsOption ("--help|-h"))
+    {
+        std::cout << usage;
+        return 0;
+    }
+
+    auto numRuns = arguments.containsOption ("--runs") ? arguments.getValueForOption ("--runs").getIntValue() : 5;
+    auto seconds = arguments.containsOption ("--seconds") ? arguments.getValueForOption ("--seconds").getDoubleValue() : 2.0;
+    auto sampleRate = arguments.containsOption ("--sample-rate") ? arguments.getValueForOption ("--sample-rate").getDoubleValue() : 48000.0;
+    auto numSamples = juce::jmax (2048, (int) (seconds * sampleRate));
+
+    BenchmarkRunner runner (numRuns, arguments.getValueForOption ("--filter"));
+
+    benchmarkOscillators (runner, sampleRate, numSamples);
+    benchmarkGrainBuffer (runner, sampleRate, numSamples);
+    benchmarkGrain (runner, sampleRate, numSamples);
+    benchmarkFFTSynth (runner, sampleRate, numSamples);
+    benchmarkVoices (runner, sampleRate, numSamples);
+    benchmarkGrainFilters (runner, sampleRate, numSamples);
+    benchmarkReverbs (runner, sampleRate, numSamples);
+    benchmarkState (runner);
+    benchmarkInstances (runner, sampleRate);
+    benchmarkProcessor (runner, sampleRate, numSamples);
+
+    if (arguments.containsOption ("--json"))
+    {
+        auto jsonFile = arguments.getFileForOption ("--json");
+
+        if (! runner.writeJson (jsonFile, sampleRate))
+        {
+            std::cerr << "Could not write " << jsonFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
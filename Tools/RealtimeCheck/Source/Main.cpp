@@ -0,0 +1,224 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 18 Oct 2026 2:03:48pm
+
+    Drives TabboulehAudioProcessor through parameter sweeps with the
+    RealtimeChecker watching processBlock, and fails if the audio path
+    allocates, locks or blocks.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+#include "../../../Source/RealtimeChecker.h"
+#include "../../Stress/Source/HostThreads.h"
+#include "../../Stress/Source/SyntheticImpulseResponse.h"
+
+static const char* usage =
+    "Usage: TabboulehRealtimeCheck [options]\n"
+    "\n"
+    "Options:\n"
+    "  --seconds=<seconds>         audio processed per scenario (default: 5)\n"
+    "  --hold-seconds=<seconds>    longest time Leftovers is held on afterwards, waiting for the\n"
+    "                              grains to use the frozen buffer's analysis (default: 10)\n"
+    "  --abort                     abort with a stack trace on the first violation\n";
+
+//==============================================================================
+/**
+ Moves every parameter of the processor along its own triangle sweep, covering the whole range at a different
+ speed for each parameter, with the odd jump to a random setting as a host automating or loading presets would.
+ */
+class ParameterSweeper
+{
+public:
+    ParameterSweeper (juce::AudioProcessor& _processor, double _sampleRate)
+        : processor (_processor), sampleRate (_sampleRate), random (2022)
+    {
+    }
+
+    /// Moves the parameters to where they should be at the given sample.
+    void update (juce::int64 sampleIndex)
+    {
+        auto seconds = sampleIndex / sampleRate;
+        auto& parameters = processor.getParameters();
+
+        // Every half second, jump somewhere random:
+        if (int (seconds * 2.0) != lastJump)
+        {
+            lastJump = int (seconds * 2.0);
+
+            for (auto* parameter : parameters)
+                if (! isHeld (parameter))
+                    parameter->setValueNotifyingHost (random.nextFloat());
+
+            return;
+        }
+
+        for (int i=0; i<parameters.size(); i++)
+        {
+            if (isHeld (parameters[i]))
+                continue;
+
+            auto period = 0.7 + 0.37 * i;
+            auto phase = std::fmod (seconds / period, 1.0);
+            parameters[i]->setValueNotifyingHost ((float) (1.0 - std::abs (2.0 * phase - 1.0)));
+        }
+    }
+
+    /**
+     Sets a parameter, and keeps it there from then on.
+
+     @param parameterID ID of the parameter
+     @param value normalised value to hold it at
+     */
+    void hold (const juce::String& parameterID, float value)
+    {
+        for (auto* parameter : processor.getParameters())
+        {
+            if (auto* parameterWithID = dynamic_cast<juce::AudioProcessorParameterWithID*> (parameter))
+            {
+                if (parameterWithID->paramID == parameterID)
+                {
+                    parameter->setValueNotifyingHost (value);
+                    held.push_back (parameter);
+                }
+            }
+        }
+    }
+
+private:
+    juce::AudioProcessor& processor;
+    double sampleRate;
+    juce::Random random;
+    int lastJump = 0;
+    std::vector<juce::AudioProcessorParameter*> held;
+
+    bool isHeld (juce::AudioProcessorParameter* parameter) const
+    {
+        return std::find (held.begin(), held.end(), parameter) != held.end();
+    }
+};
+
+/**
+ Runs one scenario, returning the number of violations it caused. Call from the stand-in audio thread (see
+ HostThreads): the processor is made and deleted on the message thread, whose loop runs its timer meanwhile.
+
+ The impulse response is loaded once playing, so that the audio thread also takes up the new convolvers whenever the
+ sweep turns "Extra Virgin" on. After the sweep, "Leftovers" is held on, in real time, until the grains take their
+ analyses from the frozen buffer: the analysis is launched by the processor's timer and runs in the background, which
+ the sweep goes by too fast for.
+ */
+static int runScenario (double sampleRate, int blockSize, double seconds, double holdSeconds, const juce::File& impulseResponse)
+{
+    RealtimeChecker::clearViolations();
+
+    std::unique_ptr<TabboulehAudioProcessor> processor;
+
+    HostThreads::callOnMessageThread ([&]
+    {
+        processor = std::make_unique<TabboulehAudioProcessor>();
+        processor->setPlayConfigDetails (2, 2, sampleRate, blockSize);
+        processor->prepareToPlay (sampleRate, blockSize);
+
+        if (! processor->loadImpulseResponse (impulseResponse))
+            std::cerr << "Could not load the impulse response, Extra Virgin will be silent" << std::endl;
+    });
+
+    ParameterSweeper sweeper (*processor, sampleRate);
+    juce::AudioBuffer<float> buffer (2, blockSize);
+    juce::MidiBuffer midiMessages;
+    juce::Random random (1);
+    juce::int64 position = 0;
+
+    auto processNextBlock = [&]
+    {
+        sweeper.update (position);
+
+        // A tone with gaps of silence, so that both the loud and the quiet paths of the synths are taken:
+        for (int i=0; i<blockSize; i++)
+        {
+            auto t = (position + i) / sampleRate;
+            auto gate = std::fmod (t, 1.5) < 1.0 ? 1.0f : 0.0f;
+            auto sample = gate * (0.4f * (float) std::sin (juce::MathConstants<double>::twoPi * 330.0 * t)
+                                  + 0.05f * (random.nextFloat() - 0.5f));
+            buffer.setSample (0, i, sample);
+            buffer.setSample (1, i, sample);
+        }
+
+        processor->processBlock (buffer, midiMessages);
+        position += blockSize;
+    };
+
+    auto numSamples = (juce::int64) (seconds * sampleRate);
+
+    while (position < numSamples)
+        processNextBlock();
+
+    sweeper.hold ("freeze", 1.0f);
+    auto lookupsBefore = processor->getPerformanceCounters().getSnapshot().analysesLookedUp;
+    auto holdEnd = juce::Time::getMillisecondCounterHiRes() + 1000.0 * holdSeconds;
+    auto blockMilliseconds = std::max (1, (int) (1000.0 * blockSize / sampleRate));
+    bool usedFrozenAnalyses = false;
+
+    while (! usedFrozenAnalyses && juce::Time::getMillisecondCounterHiRes() < holdEnd)
+    {
+        processNextBlock();
+        usedFrozenAnalyses = processor->getPerformanceCounters().getSnapshot().analysesLookedUp > lookupsBefore;
+        juce::Thread::sleep (blockMilliseconds);
+    }
+
+    HostThreads::callOnMessageThread ([&]
+    {
+        processor->releaseResources();
+        processor.reset();
+    });
+
+    auto numViolations = RealtimeChecker::getNumViolations();
+
+    std::cout << juce::String (sampleRate, 0) << " Hz, " << blockSize << " samples: "
+              << (numViolations == 0 ? juce::String ("ok") : juce::String (numViolations) + " violation(s)")
+              << (usedFrozenAnalyses ? "" : ", the frozen buffer's analysis was never used") << std::endl;
+
+    if (numViolations > 0)
+        RealtimeChecker::printViolations (std::cout);
+
+    return numViolations;
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    RealtimeChecker::enable();
+
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList arguments (argc, argv);
+
+    if (arguments.containsOption ("--help|-h"))
+    {
+        std::cout << usage;
+        return 0;
+    }
+
+    auto seconds = arguments.containsOption ("--seconds") ? arguments.getValueForOption ("--seconds").getDoubleValue() : 5.0;
+    auto holdSeconds = arguments.containsOption ("--hold-seconds") ? arguments.getValueForOption ("--hold-seconds").getDoubleValue() : 10.0;
+    RealtimeChecker::setAbortOnViolation (arguments.containsOption ("--abort"));
+
+    std::atomic<int> totalViolations { 0 };
+    SyntheticImpulseResponse impulseResponse (48000.0);
+
+    // The scenarios play on their own thread, standing in for the host's audio thread, while this one runs the
+    // message loop, so that the timer's work happens alongside processBlock as in a host:
+    HostThreads::run ([&]
+    {
+        for (auto sampleRate : { 44100.0, 48000.0, 96000.0 })
+            for (auto blockSize : { 16, 64, 256, 1024 })
+                totalViolations += runScenario (sampleRate, blockSize, seconds, holdSeconds, impulseResponse.getFile());
+    });
+
+    std::cout << (totalViolations == 0 ? "No realtime violations" : "Realtime violations found") << std::endl;
+
+    return totalViolations == 0 ? 0 : 1;
+}
@@ -0,0 +1,458 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 18 Oct 2026 11:19:32pm
+
+    Regression suite: renders fixed inputs through TabboulehAudioProcessor
+    with seeded random choices, and fails if a render moves away from the
+    golden metrics kept in Tools/Regression/Golden, or gets slower relative
+    to the reference render than it was when they were recorded.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <complex>
+#include "Scenarios.h"
+
+static const char* usage =
+    "Usage: TabboulehRegression [options]\n"
+    "\n"
+    "Options:\n"
+    "  --golden-dir=<dir>          where the golden metrics are kept (default: Tools/Regression/Golden)\n"
+    "  --presets=<library.RPL>     presets to render (default: Tabbouleh Presets.RPL)\n"
+    "  --record                    write the golden metrics and relative costs instead of checking them\n"
+    "  --tolerance=<dB>            largest difference of a window's level or brightness to the golden (default: 1)\n"
+    "  --pitch-tolerance=<cents>   largest difference of a window's pitch to the golden (default: 50)\n"
+    "  --rtf-margin=<fraction>     how far a scenario's cost relative to the reference render may rise above\n"
+    "                              the golden one (default: 0.3)\n"
+    "  --runs=<count>              renders per scenario, the fastest is kept (default: 3)\n"
+    "  --filter=<text>             only run scenarios whose name contains the text\n"
+    "  --output-dir=<dir>          write the failing renders there, to listen to them\n";
+
+//==============================================================================
+/**
+ A render boiled down to a few numbers every windowSeconds: per channel, the level, and the brightness, the level of
+ the first difference relative to the level itself, which rises with the spectral centroid; and the pitch of both
+ channels mixed, which catches the synths tracking the wrong frequency at the right level. Unlike the samples, they are
+ small enough to be kept in the repository, and don't move with the rounding of each platform's FFT and compiler.
+ */
+struct Metrics
+{
+    static constexpr double windowSeconds = 0.1;
+    static constexpr double floorDecibels = -100.0;     // Level given to silent windows
+    static constexpr double quietDecibels = -70.0;      // Level below which windows count as silent when compared
+    static constexpr double minPitch = 50.0;            // Range of the pitches looked for, in Hz
+    static constexpr double maxPitch = 2000.0;
+    static constexpr float voicedCorrelation = 0.5f;    // Normalised autocorrelation a period needs to count as a pitch
+
+    int length = 0;
+    std::vector<double> levels;                         // Every window of the left channel, then the right, in dB
+    std::vector<double> brightnesses;                   // In the same order, in dB, 0 for quiet windows
+    std::vector<double> pitches;                        // Every window of the mix, in Hz, 0 where there is none
+
+    /// Measures a render.
+    static Metrics measure (const juce::AudioBuffer<float>& render)
+    {
+        Metrics metrics;
+        metrics.length = render.getNumSamples();
+        auto windowLength = (int) (windowSeconds * Scenarios::sampleRate);
+
+        for (int channel = 0; channel < 2; channel++)
+        {
+            auto* samples = render.getReadPointer (channel);
+
+            for (int start = 0; start < render.getNumSamples(); start += windowLength)
+            {
+                auto end = std::min (start + windowLength, render.getNumSamples());
+                double energy = 0.0;
+                double differenceEnergy = 0.0;
+
+                for (int i=start; i<end; i++)
+                {
+                    auto difference = i > 0 ? (double) samples[i] - samples[i - 1] : 0.0;
+                    energy += (double) samples[i] * samples[i];
+                    differenceEnergy += difference * difference;
+                }
+
+                auto level = toDecibels (energy / (end - start));
+                metrics.levels.push_back (level);
+                metrics.brightnesses.push_back (level > quietDecibels ? toDecibels (differenceEnergy / energy) : 0.0);
+            }
+        }
+
+        // The window is padded to twice its length, so that the autocorrelation doesn't wrap around:
+        juce::dsp::FFT fft ((int) std::ceil (std::log2 (2.0 * windowLength)));
+        std::vector<float> fftData ((size_t) (2 * fft.getSize()));
+        auto numWindows = metrics.levels.size() / 2;
+
+        for (size_t window = 0; window < numWindows; window++)
+        {
+            auto start = (int) window * windowLength;
+            auto end = std::min (start + windowLength, render.getNumSamples());
+            std::fill (fftData.begin(), fftData.end(), 0.0f);
+
+            for (int i=start; i<end; i++)
+                fftData[(size_t) (i - start)] = 0.5f * (render.getSample (0, i) + render.getSample (1, i));
+
+            auto isQuiet = metrics.levels[window] <= quietDecibels && metrics.levels[numWindows + window] <= quietDecibels;
+            metrics.pitches.push_back (isQuiet ? 0.0 : findPitch (fft, fftData, end - start));
+        }
+
+        return metrics;
+    }
+
+    /**
+     Largest difference between the levels or brightnesses of two renders' windows, in dB. Returns +infinity if their
+     lengths differ.
+     */
+    double getDifference (const Metrics& golden) const
+    {
+        if (length != golden.length || levels.size() != golden.levels.size() || brightnesses.size() != golden.brightnesses.size())
+            return std::numeric_limits<double>::infinity();
+
+        double difference = 0.0;
+
+        for (size_t i=0; i<levels.size(); i++)
+        {
+            difference = std::max (difference, std::abs (std::max (levels[i], quietDecibels) - std::max (golden.levels[i], quietDecibels)));
+
+            // The brightness of a quiet window is mostly that of its noise:
+            if (levels[i] > quietDecibels && golden.levels[i] > quietDecibels)
+                difference = std::max (difference, std::abs (brightnesses[i] - golden.brightnesses[i]));
+        }
+
+        return difference;
+    }
+
+    /**
+     Largest difference between the pitches of two renders' windows, in cents. Windows where either render has no
+     pitch aren't compared, as the tone of a window on the edge of the threshold can come and go. Returns +infinity if
+     their lengths differ.
+     */
+    double getPitchDifference (const Metrics& golden) const
+    {
+        if (length != golden.length || pitches.size() != golden.pitches.size())
+            return std::numeric_limits<double>::infinity();
+
+        double difference = 0.0;
+
+        for (size_t i=0; i<pitches.size(); i++)
+            if (pitches[i] > 0.0 && golden.pitches[i] > 0.0)
+                difference = std::max (difference, 1200.0 * std::abs (std::log2 (pitches[i] / golden.pitches[i])));
+
+        return difference;
+    }
+
+    /// Writes the metrics as a JSON object.
+    juce::var toVar() const
+    {
+        auto* object = new juce::DynamicObject();
+        object->setProperty ("length", length);
+        object->setProperty ("levels", toArray (levels));
+        object->setProperty ("brightnesses", toArray (brightnesses));
+        object->setProperty ("pitches", toArray (pitches));
+        return juce::var (object);
+    }
+
+    /// Reads metrics written by toVar(), returning false if they are missing or incomplete.
+    static bool fromVar (const juce::var& value, Metrics& metrics)
+    {
+        auto levels = value.getProperty ("levels", {});
+        auto brightnesses = value.getProperty ("brightnesses", {});
+        auto pitches = value.getProperty ("pitches", {});
+
+        if (! levels.isArray() || ! brightnesses.isArray() || ! pitches.isArray())
+            return false;
+
+        metrics.length = (int) value.getProperty ("length", 0);
+        metrics.levels.clear();
+        metrics.brightnesses.clear();
+        metrics.pitches.clear();
+
+        for (auto& level : *levels.getArray())
+            metrics.levels.push_back ((double) level);
+
+        for (auto& brightness : *brightnesses.getArray())
+            metrics.brightnesses.push_back ((double) brightness);
+
+        for (auto& pitch : *pitches.getArray())
+            metrics.pitches.push_back ((double) pitch);
+
+        return metrics.length > 0;
+    }
+
+private:
+    /// Converts a power to decibels, rounded to a hundredth so that the golden file stays readable.
+    static double toDecibels (double power)
+    {
+        auto decibels = power > 0.0 ? std::max (floorDecibels, 10.0 * std::log10 (power)) : floorDecibels;
+        return std::round (100.0 * decibels) / 100.0;
+    }
+
+    /**
+     Finds the period of a window from its autocorrelation, the inverse transform of its power spectrum.
+
+     @param fft FFT of at least twice the window's length
+     @param fftData the window, zero padded, twice the FFT's size; the autocorrelation is left in it
+     @param windowLength length of the window, in samples
+     @return the pitch in Hz, rounded to a tenth, or 0 if the window has none
+     */
+    static double findPitch (const juce::dsp::FFT& fft, std::vector<float>& fftData, int windowLength)
+    {
+        fft.performRealOnlyForwardTransform (fftData.data(), true);
+        auto* bins = reinterpret_cast<std::complex<float>*> (fftData.data());
+
+        for (int bin = 0; bin <= fft.getSize() / 2; bin++)
+            bins[bin] = std::norm (bins[bin]);
+
+        fft.performRealOnlyInverseTransform (fftData.data());
+
+        auto minLag = (int) (Scenarios::sampleRate / maxPitch);
+        auto maxLag = std::min (windowLength / 2, (int) (Scenarios::sampleRate / minPitch));
+        auto isPeak = [&fftData] (int lag) { return fftData[(size_t) lag] >= fftData[(size_t) lag - 1] && fftData[(size_t) lag] >= fftData[(size_t) lag + 1]; };
+        auto highest = 0.0f;
+
+        // Only peaks count, as the lobe around lag 0 is higher than any of them at the shortest lags:
+        for (int lag = minLag + 1; lag < maxLag; lag++)
+            if (isPeak (lag))
+                highest = std::max (highest, fftData[(size_t) lag]);
+
+        if (fftData[0] <= 0.0f || highest < voicedCorrelation * fftData[0])
+            return 0.0;
+
+        // The first peak nearly as high as the highest, so that the period isn't taken for one of its multiples:
+        for (int lag = minLag + 1; lag < maxLag; lag++)
+        {
+            auto previous = fftData[(size_t) lag - 1];
+            auto current = fftData[(size_t) lag];
+            auto next = fftData[(size_t) lag + 1];
+
+            if (isPeak (lag) && current >= 0.9f * highest)
+            {
+                // Between samples, from the parabola through the peak and its neighbours:
+                auto curvature = previous - 2.0f * current + next;
+                auto offset = curvature != 0.0f ? 0.5 * (previous - next) / curvature : 0.0;
+                return std::round (10.0 * Scenarios::sampleRate / (lag + offset)) / 10.0;
+            }
+        }
+
+        return 0.0;
+    }
+
+    static juce::var toArray (const std::vector<double>& values)
+    {
+        juce::Array<juce::var> array;
+
+        for (auto value : values)
+            array.add (value);
+
+        return juce::var (array);
+    }
+};
+
+//==============================================================================
+/// Writes a render as a 32 bit float WAV, holding exactly what was rendered.
+static bool writeWav (const juce::File& file, const juce::AudioBuffer<float>& buffer)
+{
+    file.deleteFile();
+    std::unique_ptr<juce::OutputStream> stream (file.createOutputStream());
+
+    if (stream == nullptr)
+        return false;
+
+    juce::WavAudioFormat format;
+    std::unique_ptr<juce::AudioFormatWriter> writer (format.createWriterFor (stream.get(), Scenarios::sampleRate, 2, 32, {}, 0));
+
+    if (writer == nullptr)
+        return false;
+
+    stream.release();
+    return writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+}
+
+/// Returns true if two renders hold the same samples, bit for bit.
+static bool isIdentical (const juce::AudioBuffer<float>& render, const juce::AudioBuffer<float>& otherRender)
+{
+    if (render.getNumSamples() != otherRender.getNumSamples())
+        return false;
+
+    for (int channel = 0; channel < 2; channel++)
+        if (std::memcmp (render.getReadPointer (channel), otherRender.getReadPointer (channel), sizeof (float) * (size_t) render.getNumSamples()) != 0)
+            return false;
+
+    return true;
+}
+
+/// Reads a JSON object from a file, or returns a new empty one when recording.
+static juce::var readObject (const juce::File& file, bool record)
+{
+    return record ? juce::var (new juce::DynamicObject()) : juce::JSON::parse (file);
+}
+
+/**
+ Renders a scenario a few times, which must all render the same thing, and keeps the fastest.
+
+ @param render receives the first render
+ @param isDeterministic set to false if a later render differs from the first
+ @return the time spent processing, in seconds, per second of audio
+ */
+static double renderFastest (const Scenarios::Scenario& scenario, const juce::AudioBuffer<float>& input, int numRuns,
+                             juce::AudioBuffer<float>& render, bool& isDeterministic)
+{
+    juce::AudioBuffer<float> repeatedRender;
+    auto processSeconds = Scenarios::render (scenario, input, render);
+    isDeterministic = true;
+
+    for (int run = 1; run < numRuns; run++)
+    {
+        processSeconds = std::min (processSeconds, Scenarios::render (scenario, input, repeatedRender));
+        isDeterministic = isDeterministic && isIdentical (repeatedRender, render);
+    }
+
+    return processSeconds / (render.getNumSamples() / Scenarios::sampleRate);
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList arguments (argc, argv);
+
+    if (arguments.containsOption ("--help|-h"))
+    {
+        std::cout << usage;
+        return 0;
+    }
+
+    auto workingDirectory = juce::File::getCurrentWorkingDirectory();
+    auto goldenDirectory = arguments.containsOption ("--golden-dir") ? arguments.getFileForOption ("--golden-dir")
+                                                                     : workingDirectory.getChildFile ("Tools/Regression/Golden");
+    auto presetLibrary = arguments.containsOption ("--presets") ? arguments.getFileForOption ("--presets")
+                                                                : workingDirectory.getChildFile ("Tabbouleh Presets.RPL");
+    auto record = arguments.containsOption ("--record");
+    auto tolerance = arguments.containsOption ("--tolerance") ? arguments.getValueForOption ("--tolerance").getDoubleValue() : 1.0;
+    auto pitchTolerance = arguments.containsOption ("--pitch-tolerance") ? arguments.getValueForOption ("--pitch-tolerance").getDoubleValue() : 50.0;
+    auto rtfMargin = arguments.containsOption ("--rtf-margin") ? arguments.getValueForOption ("--rtf-margin").getDoubleValue() : 0.3;
+    auto numRuns = arguments.containsOption ("--runs") ? juce::jmax (1, arguments.getValueForOption ("--runs").getIntValue()) : 3;
+    auto filter = arguments.getValueForOption ("--filter");
+    auto outputDirectory = arguments.containsOption ("--output-dir") ? arguments.getFileForOption ("--output-dir") : juce::File();
+
+    if (! presetLibrary.existsAsFile())
+    {
+        std::cerr << "Could not find " << presetLibrary.getFullPathName() << ", run from the root of the repository" << std::endl;
+        return 1;
+    }
+
+    if (record && ! goldenDirectory.createDirectory())
+    {
+        std::cerr << "Could not create " << goldenDirectory.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    if (outputDirectory != juce::File())
+        outputDirectory.createDirectory();
+
+    // The golden file maps each scenario to its Metrics, and to its cost relative to the reference render:
+    auto goldenFile = goldenDirectory.getChildFile ("metrics.json");
+    auto goldens = readObject (goldenFile, record);
+
+    if (goldens.getDynamicObject() == nullptr)
+    {
+        std::cerr << "Could not read " << goldenFile.getFullPathName() << ", record it with --record" << std::endl;
+        return 1;
+    }
+
+    auto scenarios = Scenarios::makeScenarios (presetLibrary);
+
+    // Real-time factors only mean something on the machine they were measured on. The speed is checked as the cost of
+    // each scenario over the cost of the first, the default parameters on the melody, measured in the same run, which
+    // holds from one machine to the next far better:
+    juce::AudioBuffer<float> referenceRender;
+    bool isReferenceDeterministic;                  // Checked when the reference comes up as a scenario
+    auto referenceCost = renderFastest (scenarios.front(), Scenarios::makeInput (scenarios.front().inputName), numRuns, referenceRender, isReferenceDeterministic);
+
+    int numFailed = 0;
+    int numRun = 0;
+
+    for (auto& scenario : scenarios)
+    {
+        if (filter.isNotEmpty() && ! scenario.name.contains (filter))
+            continue;
+
+        numRun++;
+        juce::AudioBuffer<float> render;
+        bool isDeterministic;
+        auto cost = renderFastest (scenario, Scenarios::makeInput (scenario.inputName), numRuns, render, isDeterministic);
+        auto relativeCost = referenceCost > 0.0 ? std::round (100.0 * cost / referenceCost) / 100.0 : 0.0;
+        auto metrics = Metrics::measure (render);
+
+        std::cout << scenario.name << ": " << juce::String (cost > 0.0 ? 1.0 / cost : 0.0, 1) << "x real time, "
+                  << juce::String (relativeCost, 2) << "x the reference's cost";
+
+        if (record)
+        {
+            auto golden = metrics.toVar();
+            golden.getDynamicObject()->setProperty ("relativeCost", relativeCost);
+            goldens.getDynamicObject()->setProperty (scenario.name, golden);
+
+            std::cout << (isDeterministic ? ", recorded" : ", recorded, but the renders differ between runs") << std::endl;
+            numFailed += isDeterministic ? 0 : 1;
+            continue;
+        }
+
+        // Check the render against its golden metrics, and the speed against its golden relative cost:
+        juce::StringArray failures;
+        Metrics golden;
+
+        if (! isDeterministic)
+            failures.add ("renders differ between runs");
+
+        if (! Metrics::fromVar (goldens.getProperty (scenario.name, {}), golden))
+        {
+            failures.add ("no golden metrics");
+        }
+        else
+        {
+            auto difference = metrics.getDifference (golden);
+            auto pitchDifference = metrics.getPitchDifference (golden);
+            std::cout << ", " << (std::isfinite (difference) ? juce::String (difference, 2) + " dB and " + juce::String (pitchDifference, 0) + " cents"
+                                                             : juce::String ("length")) << " difference";
+
+            if (difference > tolerance)
+                failures.add ("differs from the golden metrics");
+
+            if (pitchDifference > pitchTolerance)
+                failures.add ("differs from the golden pitches");
+
+            auto goldenCost = (double) goldens.getProperty (scenario.name, {}).getProperty ("relativeCost", 0.0);
+
+            if (goldenCost <= 0.0)
+                failures.add ("no golden relative cost");
+            else if (relativeCost > goldenCost * (1.0 + rtfMargin))
+                failures.add ("slower than the golden " + juce::String (goldenCost, 2) + "x the reference's cost");
+        }
+
+        if (failures.isEmpty())
+        {
+            std::cout << ", ok" << std::endl;
+            continue;
+        }
+
+        std::cout << ", FAILED: " << failures.joinIntoString (", ") << std::endl;
+        numFailed++;
+
+        if (outputDirectory != juce::File())
+            writeWav (outputDirectory.getChildFile (scenario.name + ".wav"), render);
+    }
+
+    if (record && ! goldenFile.replaceWithText (juce::JSON::toString (goldens)))
+    {
+        std::cerr << "Could not write " << goldenFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    std::cout << numRun - numFailed << " of " << numRun << " scenarios passed" << std::endl;
+    return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,207 @@
+/*
+  ==============================================================================
+
+    Scenarios.h
+    Created: 18 Oct 2026 11:24:50pm
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+#include "../../Render/Source/StateLoader.h"
+
+/**
+ The inputs and settings the regression suite renders, all of them built in code so that they are the same on every
+ machine: an input signal, a plugin state, and a few parameters set on top of it.
+ */
+namespace Scenarios
+{
+    static constexpr double sampleRate = 48000.0;
+    static constexpr int blockSize = 512;
+    static constexpr double inputSeconds = 6.0;
+    static constexpr double tailSeconds = 2.0;
+    static constexpr juce::int64 randomSeed = 2022;
+
+    /// One render: an input through a state.
+    struct Scenario
+    {
+        juce::String name;                                  // Also the name of its golden file
+        juce::String inputName;
+        juce::MemoryBlock state;                            // Empty for the default parameters
+        std::vector<std::pair<juce::String, float>> parameterValues;    // Set after the state, in their own units
+    };
+
+    //==========================================================================
+    /// A melody of harmonic tones with gaps between the notes, for the pitch tracking and the synths.
+    inline void fillTones (juce::AudioBuffer<float>& buffer)
+    {
+        const double notes[] = { 220.0, 277.18, 329.63, 440.0, 392.0, 246.94 };
+        double phase = 0.0;
+
+        for (int i=0; i<buffer.getNumSamples(); i++)
+        {
+            auto t = i / sampleRate;
+            auto note = (int) (t / 0.5);
+            auto withinNote = std::fmod (t, 0.5);
+            auto gate = withinNote < 0.4 ? (float) std::sin (juce::MathConstants<double>::pi * withinNote / 0.4) : 0.0f;
+
+            phase += juce::MathConstants<double>::twoPi * notes[note % 6] / sampleRate;
+            auto sample = gate * (0.4f * (float) std::sin (phase) + 0.15f * (float) std::sin (2.0 * phase) + 0.08f * (float) std::sin (3.0 * phase));
+
+            buffer.setSample (0, i, sample);
+            buffer.setSample (1, i, sample * 0.9f);
+        }
+    }
+
+    /// Decaying noise bursts on an uneven rhythm, for the onsets and the quiet paths between them.
+    inline void fillDrums (juce::AudioBuffer<float>& buffer)
+    {
+        juce::Random random (7);
+        const double hits[] = { 0.0, 0.375, 0.5, 0.875, 1.25, 1.5 };
+        auto envelope = 0.0f;
+
+        for (int i=0; i<buffer.getNumSamples(); i++)
+        {
+            auto withinBar = std::fmod (i / sampleRate, 1.75);
+
+            for (auto hit : hits)
+                if ((int) (withinBar * sampleRate) == (int) (hit * sampleRate))
+                    envelope = 0.8f;
+
+            envelope *= 0.9995f;
+            buffer.setSample (0, i, envelope * (random.nextFloat() * 2.0f - 1.0f));
+            buffer.setSample (1, i, envelope * (random.nextFloat() * 2.0f - 1.0f));
+        }
+    }
+
+    /// A logarithmic sine sweep from 50 Hz to 10 kHz over a quiet noise floor, for the filters and the whole spectrum.
+    inline void fillSweep (juce::AudioBuffer<float>& buffer)
+    {
+        juce::Random random (11);
+        double phase = 0.0;
+
+        for (int i=0; i<buffer.getNumSamples(); i++)
+        {
+            auto frequency = 50.0 * std::pow (200.0, i / (double) buffer.getNumSamples());
+            phase += juce::MathConstants<double>::twoPi * frequency / sampleRate;
+            auto noise = 0.01f * (random.nextFloat() * 2.0f - 1.0f);
+
+            buffer.setSample (0, i, 0.3f * (float) std::sin (phase) + noise);
+            buffer.setSample (1, i, 0.3f * (float) std::cos (phase) + noise);
+        }
+    }
+
+    /// Returns the named input, inputSeconds long and stereo.
+    inline juce::AudioBuffer<float> makeInput (const juce::String& inputName)
+    {
+        juce::AudioBuffer<float> buffer (2, (int) (inputSeconds * sampleRate));
+
+        if (inputName == "tones")
+            fillTones (buffer);
+        else if (inputName == "drums")
+            fillDrums (buffer);
+        else
+            fillSweep (buffer);
+
+        return buffer;
+    }
+
+    //==========================================================================
+    /**
+     Lists every scenario: each input through the default parameters, through every preset of the library, and
+     through the modes the presets don't use.
+
+     @param presetLibrary preset library whose presets are rendered, such as the shipped "Tabbouleh Presets.RPL"
+     */
+    inline std::vector<Scenario> makeScenarios (const juce::File& presetLibrary)
+    {
+        std::vector<Scenario> states;
+        states.push_back ({ "default", {}, {}, {} });
+
+        for (auto& presetName : StateLoader::getPresetNames (presetLibrary))
+        {
+            Scenario preset { presetName.toLowerCase().retainCharacters ("abcdefghijklmnopqrstuvwxyz0123456789 ").replaceCharacter (' ', '-'), {}, {}, {} };
+
+            if (StateLoader::loadFromPresetLibrary (presetLibrary, presetName, preset.state))
+                states.push_back (preset);
+        }
+
+        states.push_back ({ "salt", {}, {}, { { "onset_Snap", 1.0f } } });
+        states.push_back ({ "blender", {}, {}, { { "grain_Spectral", 1.0f }, { "spectral_Stretch", 0.5f }, { "spectral_Smear", 0.3f } } });
+        states.push_back ({ "cucumber", {}, {}, { { "grain_Filter", 1.0f }, { "grain_FilterCutoff", 1500.0f }, { "grain_FilterRandomness", 0.8f } } });
+        states.push_back ({ "one-onion-sine", {}, {}, { { "active_Grains", 1.0f }, { "synth_oscSelect", 1.0f } } });
+
+        std::vector<Scenario> scenarios;
+
+        for (auto* inputName : { "tones", "drums", "sweep" })
+        {
+            for (auto& state : states)
+            {
+                auto scenario = state;
+                scenario.name = inputName + juce::String ("_") + state.name;
+                scenario.inputName = inputName;
+                scenarios.push_back (scenario);
+            }
+        }
+
+        return scenarios;
+    }
+
+    /// Sets a parameter of the processor from its real (not normalised) value.
+    inline void setParameter (juce::AudioProcessor& processor, const juce::String& parameterID, float value)
+    {
+        for (auto* parameter : processor.getParameters())
+            if (auto* rangedParameter = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+                if (rangedParameter->paramID == parameterID)
+                    rangedParameter->setValueNotifyingHost (rangedParameter->convertTo0to1 (value));
+    }
+
+    /**
+     Renders a scenario offline, as TabboulehRender would, with the random choices seeded.
+
+     @param scenario what to render
+     @param input the scenario's input
+     @param output receives the input's length plus tailSeconds of output
+     @return the time spent inside processBlock, in seconds
+     */
+    inline double render (const Scenario& scenario, const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output)
+    {
+        TabboulehAudioProcessor processor;
+        processor.setNonRealtime (true);
+        processor.setPlayConfigDetails (2, 2, sampleRate, blockSize);
+        processor.setRandomSeed (randomSeed);
+
+        if (scenario.state.getSize() > 0)
+            processor.setStateInformation (scenario.state.getData(), (int) scenario.state.getSize());
+
+        for (auto& parameterValue : scenario.parameterValues)
+            setParameter (processor, parameterValue.first, parameterValue.second);
+
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        auto totalLength = input.getNumSamples() + (int) (tailSeconds * sampleRate);
+        output.setSize (2, totalLength);
+        output.clear();
+        output.copyFrom (0, 0, input, 0, 0, input.getNumSamples());
+        output.copyFrom (1, 0, input, 1, 0, input.getNumSamples());
+
+        juce::MidiBuffer midiMessages;
+        juce::int64 processTicks = 0;
+
+        for (int position = 0; position < totalLength; position += blockSize)
+        {
+            auto numSamples = std::min (blockSize, totalLength - position);
+            juce::AudioBuffer<float> block (output.getArrayOfWritePointers(), 2, position, numSamples);
+
+            auto blockStartTicks = juce::Time::getHighResolutionTicks();
+            processor.processBlock (block, midiMessages);
+            processTicks += juce::Time::getHighResolutionTicks() - blockStartTicks;
+        }
+
+        processor.releaseResources();
+        return juce::Time::highResolutionTicksToSeconds (processTicks);
+    }
+}
@@ -0,0 +1,173 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 18 Oct 2026 10:36:05am
+
+    Headless renderer: streams audio files through TabboulehAudioProcessor
+    faster than real time, one file per core.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "StateLoader.h"
+#include "RenderJob.h"
+
+static const char* usage =
+    "Usage: TabboulehRender [options] <input files...>\n"
+    "\n"
+    "Options:\n"
+    "  --state=<file>                  state written by getStateInformation (.xml or raw binary)\n"
+    "  --state=<library.RPL>:<name>    preset from a REAPER preset library\n"
+    "  --ir=<file>                     impulse response for Oil to convolve with (turns Extra Virgin on)\n"
+    "  --source=<file>                 audio file for every grain to read from (turns Pantry up)\n"
+    "  --output-dir=<dir>              where to write the rendered files (default: current directory)\n"
+    "  --format=<wav|flac>             output format (default: same as the input)\n"
+    "  --block-size=<samples>          processBlock size (default: 512)\n"
+    "  --bit-depth=<bits>              output bit depth (default: 24)\n"
+    "  --tail=<seconds|auto>           silence rendered after each input, auto for the plugin's\n"
+    "                                  reported tail (default: 0)\n"
+    "  --history=<float32|float16>     how the grain buffer stores its samples (default: float32)\n"
+    "  --trace                         write a timeline of processBlock next to each rendered file, for\n"
+    "                                  chrome://tracing or ui.perfetto.dev\n"
+    "  --threads=<count>               files rendered in parallel (default: one per core)\n";
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList arguments (argc, argv);
+
+    if (arguments.size() == 0 || arguments.containsOption ("--help|-h"))
+    {
+        std::cout << usage;
+        return 0;
+    }
+
+    // Gather the batch settings:
+    RenderSettings settings;
+    settings.outputDirectory = juce::File::getCurrentWorkingDirectory();
+
+    if (arguments.containsOption ("--state"))
+    {
+        if (! StateLoader::loadFromArgument (arguments.getValueForOption ("--state"), settings.state))
+        {
+            std::cerr << "Could not load state " << arguments.getValueForOption ("--state") << std::endl;
+            return 1;
+        }
+    }
+
+    if (arguments.containsOption ("--ir"))
+        settings.impulseResponse = arguments.getFileForOption ("--ir");
+
+    if (arguments.containsOption ("--source"))
+        settings.grainSource = arguments.getFileForOption ("--source");
+
+    if (arguments.containsOption ("--output-dir"))
+        settings.outputDirectory = arguments.getFileForOption ("--output-dir");
+
+    if (arguments.containsOption ("--format"))
+        settings.outputFormat = arguments.getValueForOption ("--format").toLowerCase();
+
+    if (arguments.containsOption ("--block-size"))
+        settings.blockSize = juce::jmax (1, arguments.getValueForOption ("--block-size").getIntValue());
+
+    if (arguments.containsOption ("--bit-depth"))
+        settings.bitDepth = arguments.getValueForOption ("--bit-depth").getIntValue();
+
+    if (arguments.containsOption ("--tail"))
+    {
+        auto tail = arguments.getValueForOption ("--tail");
+        settings.tailSeconds = tail == "auto" ? -1.0 : juce::jmax (0.0, tail.getDoubleValue());
+    }
+
+    if (arguments.containsOption ("--history"))
+    {
+        auto history = arguments.getValueForOption ("--history");
+
+        if (history != "float32" && history != "float16")
+        {
+            std::cerr << "Unknown history storage " << history << ", use float32 or float16" << std::endl;
+            return 1;
+        }
+
+        settings.historyStorage = history == "float16" ? GrainBuffer::Storage::float16 : GrainBuffer::Storage::float32;
+    }
+
+    settings.writeTrace = arguments.containsOption ("--trace");
+
+    auto numThreads = juce::SystemStats::getNumCpus();
+
+    if (arguments.containsOption ("--threads"))
+        numThreads = juce::jmax (1, arguments.getValueForOption ("--threads").getIntValue());
+
+    // Everything that isn't an option is a file to render:
+    juce::Array<juce::File> inputFiles;
+
+    for (auto& argument : arguments.arguments)
+        if (! argument.isOption())
+            inputFiles.add (argument.resolveAsFile());
+
+    if (inputFiles.isEmpty())
+    {
+        std::cerr << usage;
+        return 1;
+    }
+
+    if (! settings.outputDirectory.createDirectory())
+    {
+        std::cerr << "Could not create " << settings.outputDirectory.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    // Render every file on the pool:
+    std::vector<RenderResult> results ((size_t) inputFiles.size());
+    juce::OwnedArray<RenderJob> jobs;
+    juce::ThreadPool pool (numThreads);
+
+    auto batchStartTicks = juce::Time::getHighResolutionTicks();
+
+    for (int i=0; i<inputFiles.size(); i++)
+        pool.addJob (jobs.add (new RenderJob (inputFiles[i], settings, results[(size_t) i])), false);
+
+    for (auto* job : jobs)
+        pool.waitForJobToFinish (job, -1);
+
+    auto batchSeconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - batchStartTicks);
+
+    // Report:
+    double totalAudioSeconds = 0.0;
+    int numFailed = 0;
+
+    for (auto& result : results)
+    {
+        if (result.succeeded)
+        {
+            totalAudioSeconds += result.audioSeconds;
+
+            std::cout << result.inputFile.getFileName()
+                      << ": " << juce::String (result.audioSeconds, 2) << " s of audio"
+                      << ", processBlock " << juce::String (result.getRealTimeFactor(), 1) << "x real time"
+                      << ", job " << juce::String (result.totalSeconds, 2) << " s"
+                      << " -> " << result.outputFile.getFullPathName() << std::endl;
+
+            std::cout << "    block p50 " << juce::String (result.counters.blockMicrosecondsMedian, 0) << " us"
+                      << ", p99 " << juce::String (result.counters.blockMicroseconds99, 0) << " us"
+                      << ", FFT " << juce::String (result.counters.fftShareOfProcessing * 100.0, 1) << "% of processBlock"
+                      << ", " << juce::String (result.counters.fftMicrosecondsPerAnalysis, 0) << " us per analysis"
+                      << ", skipped grains " << juce::String (result.counters.skippedGrainRate * 100.0, 1) << "%" << std::endl;
+        }
+        else
+        {
+            numFailed++;
+            std::cerr << result.inputFile.getFileName() << ": " << result.errorMessage << std::endl;
+        }
+    }
+
+    std::cout << "Rendered " << juce::String (totalAudioSeconds, 2) << " s of audio in "
+              << juce::String (batchSeconds, 2) << " s on " << numThreads << " threads: "
+              << juce::String (batchSeconds > 0.0 ? totalAudioSeconds / batchSeconds : 0.0, 1) << "x real time" << std::endl;
+
+    return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,228 @@
+/*
+  ==============================================================================
+
+    RenderJob.h
+    Created: 18 Oct 2026 10:58:37am
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+
+/// Settings shared by every file of a batch.
+struct RenderSettings
+{
+    juce::MemoryBlock state;                // Plugin state, left empty to use the default parameters
+    juce::File impulseResponse;             // Impulse response for "Oil" to convolve with, overriding the state's
+    juce::File grainSource;                 // Audio file for the grains to read from ("Pantry"), overriding the state's
+    juce::File outputDirectory;             // Where rendered files are written
+    juce::String outputFormat;              // "wav" or "flac", empty to keep the input format
+    int blockSize = 512;                    // Samples handed to processBlock at a time
+    int bitDepth = 24;                      // Bit depth of the rendered files
+    bool writeTrace = false;                // Also write a timeline of processBlock next to each rendered file
+    GrainBuffer::Storage historyStorage = GrainBuffer::Storage::float32;    // How the grain buffer stores its samples
+    double tailSeconds = 0.0;               // Silence fed after the input, to let the grains and reverb ring out.
+                                            // Negative to use the tail the processor reports for its state.
+};
+
+/// Outcome of a single render.
+struct RenderResult
+{
+    juce::File inputFile;
+    juce::File outputFile;
+    double audioSeconds = 0.0;              // Length of the rendered audio, tail included
+    double processSeconds = 0.0;            // Time spent inside processBlock
+    double totalSeconds = 0.0;              // Time spent on the whole job, file IO included
+    PerformanceCounters::Report counters;   // What the processor did over the whole render
+    bool succeeded = false;
+    juce::String errorMessage;
+
+    /// Seconds of audio rendered per second of processBlock time.
+    double getRealTimeFactor() const
+    {
+        return processSeconds > 0.0 ? audioSeconds / processSeconds : 0.0;
+    }
+};
+
+/**
+ ThreadPool job streaming one audio file through its own TabboulehAudioProcessor instance.
+
+ The input is read, processed and written one block at a time, so memory use does not depend on the
+ length of the file. Each job owns its processor, so any number of jobs can run side by side.
+ */
+class RenderJob  : public juce::ThreadPoolJob
+{
+public:
+
+    /**
+     @param _inputFile file to render
+     @param _settings batch settings, which must outlive the job
+     @param _result where the outcome is stored once the job has run
+     */
+    RenderJob (const juce::File& _inputFile, const RenderSettings& _settings, RenderResult& _result)
+        : juce::ThreadPoolJob ("Render " + _inputFile.getFileName()),
+          inputFile (_inputFile),
+          settings (_settings),
+          result (_result)
+    {
+        result.inputFile = inputFile;
+    }
+
+    JobStatus runJob() override
+    {
+        auto jobStartTicks = juce::Time::getHighResolutionTicks();
+        render();
+        result.totalSeconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - jobStartTicks);
+
+        return jobHasFinished;
+    }
+
+private:
+    juce::File inputFile;
+    const RenderSettings& settings;
+    RenderResult& result;
+
+    /// Sets the error message of the result, returning false for convenience.
+    bool fail (const juce::String& message)
+    {
+        result.errorMessage = message;
+        return false;
+    }
+
+    bool render()
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        // Open the input:
+        std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (inputFile));
+
+        if (reader == nullptr)
+            return fail ("could not read " + inputFile.getFullPathName());
+
+        // Open the output, in the same format as the input unless asked otherwise:
+        auto extension = settings.outputFormat.isNotEmpty() ? "." + settings.outputFormat : inputFile.getFileExtension();
+        result.outputFile = settings.outputDirectory.getChildFile (inputFile.getFileNameWithoutExtension() + "_tabbouleh" + extension);
+
+        auto* outputFormat = formatManager.findFormatForFileExtension (extension);
+
+        if (outputFormat == nullptr)
+            return fail ("unsupported output format " + extension);
+
+        result.outputFile.deleteFile();
+        std::unique_ptr<juce::OutputStream> outputStream (result.outputFile.createOutputStream());
+
+        if (outputStream == nullptr)
+            return fail ("could not create " + result.outputFile.getFullPathName());
+
+        std::unique_ptr<juce::AudioFormatWriter> writer (outputFormat->createWriterFor (outputStream.get(),
+                                                                                        reader->sampleRate,
+                                                                                        2,
+                                                                                        settings.bitDepth,
+                                                                                        {},
+                                                                                        0));
+        if (writer == nullptr)
+            return fail ("could not create a writer for " + result.outputFile.getFullPathName());
+
+        // The writer now owns the stream:
+        outputStream.release();
+
+        // Set up the processor as a host would:
+        auto sampleRate = reader->sampleRate;
+        auto blockSize = settings.blockSize;
+
+        TabboulehAudioProcessor processor;
+        processor.setNonRealtime (true);
+        processor.setPlayConfigDetails (2, 2, sampleRate, blockSize);
+        processor.setHistoryStorage (settings.historyStorage);
+
+        if (settings.state.getSize() > 0)
+            processor.setStateInformation (settings.state.getData(), (int) settings.state.getSize());
+
+        // An impulse response given on its own turns "Extra Virgin" on:
+        if (settings.impulseResponse != juce::File())
+        {
+            if (! processor.loadImpulseResponse (settings.impulseResponse))
+                return fail ("could not read " + settings.impulseResponse.getFullPathName());
+
+            for (auto* parameter : processor.getParameters())
+                if (auto* parameterWithID = dynamic_cast<juce::AudioProcessorParameterWithID*> (parameter))
+                    if (parameterWithID->paramID == "reverb_Convolution")
+                        parameterWithID->setValueNotifyingHost (1.0f);
+        }
+
+        // A grain source given on its own makes every grain read from it:
+        if (settings.grainSource != juce::File())
+        {
+            processor.loadGrainSourceFile (settings.grainSource);
+
+            for (auto* parameter : processor.getParameters())
+                if (auto* parameterWithID = dynamic_cast<juce::AudioProcessorParameterWithID*> (parameter))
+                    if (parameterWithID->paramID == "source_Chance")
+                        parameterWithID->setValueNotifyingHost (1.0f);
+        }
+
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        // The grain source and impulse response load in the background, at the rate just prepared, and must be there
+        // from the first block:
+        if (processor.getGrainSourceFile() != juce::File() && ! processor.waitForGrainSourceFile (-1))
+            return fail ("could not read " + processor.getGrainSourceFile().getFullPathName());
+
+        if (processor.getImpulseResponseFile() != juce::File() && ! processor.waitForImpulseResponse (-1))
+            return fail ("could not read " + processor.getImpulseResponseFile().getFullPathName());
+
+        auto traceFile = result.outputFile.withFileExtension ("trace.json");
+
+        if (settings.writeTrace && ! processor.getTraceRecorder().start (traceFile))
+            return fail ("could not create " + traceFile.getFullPathName());
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        juce::MidiBuffer midiMessages;
+
+        auto inputLength = reader->lengthInSamples;
+        auto tailSeconds = settings.tailSeconds < 0.0 ? processor.getTailLengthSeconds() : settings.tailSeconds;
+
+        // A frozen buffer never stops ringing, don't render an endless tail:
+        if (! std::isfinite (tailSeconds))
+            tailSeconds = 0.0;
+        auto totalLength = inputLength + (juce::int64) (tailSeconds * sampleRate);
+        juce::int64 processTicks = 0;
+
+        // Stream the file through processBlock:
+        for (juce::int64 position = 0; position < totalLength; position += blockSize)
+        {
+            if (shouldExit())
+                return fail ("cancelled");
+
+            auto numSamples = (int) std::min ((juce::int64) blockSize, totalLength - position);
+            buffer.setSize (2, numSamples, false, false, true);
+            buffer.clear();
+
+            // Mono files are copied to both channels by the reader, the tail is left silent:
+            if (position < inputLength)
+                reader->read (&buffer, 0, (int) std::min ((juce::int64) numSamples, inputLength - position), position, true, true);
+
+            auto blockStartTicks = juce::Time::getHighResolutionTicks();
+            processor.processBlock (buffer, midiMessages);
+            processTicks += juce::Time::getHighResolutionTicks() - blockStartTicks;
+
+            if (! writer->writeFromAudioSampleBuffer (buffer, 0, numSamples))
+                return fail ("could not write to " + result.outputFile.getFullPathName());
+        }
+
+        result.counters = PerformanceCounters::compare ({}, processor.getPerformanceCounters().getSnapshot());
+        processor.getTraceRecorder().stop();
+        processor.releaseResources();
+
+        result.audioSeconds = (double) totalLength / sampleRate;
+        result.processSeconds = juce::Time::highResolutionTicksToSeconds (processTicks);
+        result.succeeded = true;
+        return true;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (RenderJob)
+};
@@ -0,0 +1,167 @@
+/*
+  ==============================================================================
+
+    StateLoader.h
+    Created: 18 Oct 2026 10:41:12am
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../../Source/BinaryState.h"
+
+/**
+ Collection of helpers turning files on disk into a memory block that can be handed straight to
+ TabboulehAudioProcessor::setStateInformation().
+
+ Three kinds of file are understood:
+ * A REAPER preset library (.RPL), such as the shipped "Tabbouleh Presets.RPL", from which a preset is picked by name.
+ * A plain XML file holding the "ParameterTree" element written by getStateInformation().
+ * A binary file holding the exact bytes produced by getStateInformation().
+ */
+namespace StateLoader
+{
+    /// Magic number at the start of every block written by juce::AudioProcessor::copyXmlToBinary ("VC2!").
+    static constexpr juce::uint32 xmlBinaryMagic = 0x21324356;
+
+    /**
+     Finds the start of the plugin state within some larger chunk, as the VST3 wrapper stores it behind its own header.
+     The state is either a BinaryState, or a copyXmlToBinary() block written by older versions.
+
+     @return offset of the block in bytes, or -1 if it could not be found.
+     */
+    inline int findStateBlock (const juce::MemoryBlock& chunk)
+    {
+        auto* bytes = static_cast<const juce::uint8*> (chunk.getData());
+
+        for (size_t i = 0; i + 8 <= chunk.getSize(); i++)
+        {
+            if (bytes[i] == 'V' && bytes[i+1] == 'C' && bytes[i+2] == '2' && bytes[i+3] == '!')
+                return (int) i;
+
+            if (BinaryState::isBinaryState (bytes + i, (int) (chunk.getSize() - i)))
+                return (int) i;
+        }
+
+        return -1;
+    }
+
+    /**
+     Reads a named preset out of a REAPER preset library.
+
+     Each preset is stored as base64 text spread over several lines between "<PRESET `name`" and ">".
+     The decoded chunk is the VST3 state, in which the plugin's own state is embedded.
+
+     @param libraryFile the .RPL file
+     @param presetName name of the preset, as displayed in REAPER
+     @param destState memory block receiving the plugin state
+     @return true if the preset was found and contained a plugin state.
+     */
+    inline bool loadFromPresetLibrary (const juce::File& libraryFile, const juce::String& presetName, juce::MemoryBlock& destState)
+    {
+        juce::StringArray lines;
+        lines.addLines (libraryFile.loadFileAsString());
+
+        juce::String base64;
+        bool insidePreset = false;
+
+        for (auto& line : lines)
+        {
+            auto trimmedLine = line.trim();
+
+            if (! insidePreset)
+            {
+                insidePreset = trimmedLine.startsWith ("<PRESET")
+                            && trimmedLine.fromFirstOccurrenceOf ("`", false, false)
+                                          .upToLastOccurrenceOf ("`", false, false) == presetName;
+                continue;
+            }
+
+            if (trimmedLine == ">")
+                break;
+
+            base64 += trimmedLine;
+        }
+
+        if (base64.isEmpty())
+            return false;
+
+        juce::MemoryOutputStream decoded;
+        if (! juce::Base64::convertFromBase64 (decoded, base64))
+            return false;
+
+        auto chunk = decoded.getMemoryBlock();
+        auto offset = findStateBlock (chunk);
+
+        if (offset < 0)
+            return false;
+
+        destState.replaceAll (static_cast<const char*> (chunk.getData()) + offset, chunk.getSize() - (size_t) offset);
+        return true;
+    }
+
+    /**
+     Lists the presets of a REAPER preset library, in the order they are stored.
+
+     @param libraryFile the .RPL file
+     */
+    inline juce::StringArray getPresetNames (const juce::File& libraryFile)
+    {
+        juce::StringArray lines, names;
+        lines.addLines (libraryFile.loadFileAsString());
+
+        for (auto& line : lines)
+        {
+            auto trimmedLine = line.trim();
+
+            if (trimmedLine.startsWith ("<PRESET"))
+                names.add (trimmedLine.fromFirstOccurrenceOf ("`", false, false).upToLastOccurrenceOf ("`", false, false));
+        }
+
+        return names;
+    }
+
+    /**
+     Reads a state file, either the XML text or the raw binary block written by getStateInformation().
+
+     @param stateFile the file to load
+     @param destState memory block receiving the plugin state
+     @return true if the file could be read.
+     */
+    inline bool loadFromStateFile (const juce::File& stateFile, juce::MemoryBlock& destState)
+    {
+        if (stateFile.hasFileExtension ("xml"))
+        {
+            auto xml = juce::parseXML (stateFile);
+
+            if (xml == nullptr)
+                return false;
+
+            destState.reset();
+            juce::AudioProcessor::copyXmlToBinary (*xml, destState);
+            return true;
+        }
+
+        return stateFile.loadFileAsData (destState);
+    }
+
+    /**
+     Interprets a command line state argument.
+
+     "library.RPL:Preset Name" picks a preset from a preset library, anything else is treated as a state file.
+     */
+    inline bool loadFromArgument (const juce::String& argument, juce::MemoryBlock& destState)
+    {
+        if (argument.containsIgnoreCase (".RPL:"))
+        {
+            auto libraryPath = argument.upToLastOccurrenceOf (":", false, false);
+            auto presetName = argument.fromLastOccurrenceOf (":", false, false);
+
+            return loadFromPresetLibrary (juce::File::getCurrentWorkingDirectory().getChildFile (libraryPath), presetName, destState);
+        }
+
+        return loadFromStateFile (juce::File::getCurrentWorkingDirectory().getChildFile (argument), destState);
+    }
+}
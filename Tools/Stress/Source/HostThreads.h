@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    HostThreads.h
+    Created: 18 Oct 2026 11:48:15pm
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+
+/**
+ The threads of a host, for the tools playing the processor in real time: a thread of its own stands in for the audio
+ thread, while the main thread runs the message loop, so that the processor's timers start the freeze analyses and
+ collect the old convolvers as they would in a host. The processors are made, prepared, released and deleted on the
+ message thread, which their timers live on. Shared by TabboulehStress and TabboulehRealtimeCheck.
+ */
+class HostThreads
+{
+public:
+    /**
+     Runs a function on the stand-in audio thread, and the message loop until it returns. Call from main().
+
+     @param function what the host's audio thread would do
+     */
+    static void run (std::function<void()> function)
+    {
+        juce::Thread::launch ([function]
+        {
+            function();
+            juce::MessageManager::getInstance()->stopDispatchLoop();
+        });
+
+        juce::MessageManager::getInstance()->runDispatchLoop();
+    }
+
+    /**
+     Runs a function on the message thread, and waits for it to return. Call from the stand-in audio thread.
+
+     @param function what the host's message thread would do, such as making or deleting a processor
+     */
+    static void callOnMessageThread (std::function<void()> function)
+    {
+        juce::MessageManager::getInstance()->callFunctionOnMessageThread ([] (void* userData) -> void*
+        {
+            (*static_cast<std::function<void()>*> (userData))();
+            return nullptr;
+        }, &function);
+    }
+};
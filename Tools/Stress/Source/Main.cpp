@@ -0,0 +1,261 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 18 Oct 2026 4:58:02am
+
+    Worst-case stress suite: plays adversarial parameter schedules through
+    one or more instances of TabboulehAudioProcessor at real-time block sizes,
+    and fails if the callbacks come too close to their deadline.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+#include "HostThreads.h"
+#include "Schedules.h"
+#include "SyntheticImpulseResponse.h"
+
+static const char* usage =
+    "Usage: TabboulehStress [options]\n"
+    "\n"
+    "Options:\n"
+    "  --instances=<count>         instances processed one after the other in every callback (default: 1)\n"
+    "  --block-size=<list>         comma separated block sizes, in samples (default: 64)\n"
+    "  --sample-rate=<list>        comma separated sample rates, in Hz (default: 48000)\n"
+    "  --seconds=<seconds>         audio played per schedule (default: 10)\n"
+    "  --max-load=<fraction>       largest 99.9th percentile of the callback times, as a fraction of\n"
+    "                              the deadline (default: 0.7)\n"
+    "  --governor                  leave the QualityGovernor on, as in a host\n"
+    "  --filter=<text>             only play schedules whose name contains the text\n"
+    "  --trace-dir=<dir>           write a timeline of the first instance of every run there, for\n"
+    "                              chrome://tracing or ui.perfetto.dev\n"
+    "\n"
+    "A run fails if its 99.9th percentile is above the largest load, or if any callback misses the deadline.\n";
+
+/// Warm up before timing, so that the first analyses and cold caches don't count.
+static constexpr double warmUpSeconds = 0.5;
+
+//==============================================================================
+/// Fills a stereo buffer with a loud harmonic tone gliding over an octave, over some noise, that never goes quiet.
+static void fillInput (juce::AudioBuffer<float>& buffer, double sampleRate)
+{
+    juce::Random random (99);
+    double phase = 0.0;
+
+    for (int i=0; i<buffer.getNumSamples(); i++)
+    {
+        auto frequency = 220.0 * std::pow (2.0, 0.5 + 0.5 * std::sin (juce::MathConstants<double>::twoPi * 0.3 * i / sampleRate));
+        phase += juce::MathConstants<double>::twoPi * frequency / sampleRate;
+
+        auto sample = 0.4f * (float) std::sin (phase) + 0.2f * (float) std::sin (2.0 * phase) + 0.1f * (float) std::sin (3.0 * phase)
+                    + 0.05f * (random.nextFloat() * 2.0f - 1.0f);
+
+        buffer.setSample (0, i, sample);
+        buffer.setSample (1, i, sample * 0.9f);
+    }
+}
+
+/// Parses a comma separated list of numbers, or returns the default when the option is missing.
+static std::vector<double> parseList (const juce::ArgumentList& arguments, const juce::String& option, double defaultValue)
+{
+    if (! arguments.containsOption (option))
+        return { defaultValue };
+
+    std::vector<double> values;
+
+    for (auto& token : juce::StringArray::fromTokens (arguments.getValueForOption (option), ",", ""))
+        if (token.trim().getDoubleValue() > 0.0)
+            values.push_back (token.trim().getDoubleValue());
+
+    return values;
+}
+
+//==============================================================================
+/// Callback times of a run, as fractions of the deadline.
+struct Loads
+{
+    double mean = 0.0;
+    double percentile999 = 0.0;
+    double max = 0.0;
+    int missedDeadlines = 0;
+};
+
+/**
+ Plays a schedule through the instances, as a single threaded host would: every callback processes each instance in
+ turn, and is timed as a whole against the duration of one block. Call from the stand-in audio thread (see
+ HostThreads): the instances are made and deleted on the message thread.
+
+ @param impulseResponse response the convolution reverb of every instance is loaded with
+ @param traceFile file to write the timeline of the first instance to, or an empty File
+ @return the loads of the callbacks after the warm up
+ */
+static Loads runSchedule (const Schedules::Schedule& schedule, int numInstances, double sampleRate, int blockSize, double seconds, bool useGovernor,
+                          const juce::File& impulseResponse, const juce::File& traceFile)
+{
+    std::vector<std::unique_ptr<TabboulehAudioProcessor>> processors;
+
+    HostThreads::callOnMessageThread ([&]
+    {
+        for (int i=0; i<numInstances; i++)
+        {
+            auto processor = std::make_unique<TabboulehAudioProcessor>();
+            processor->setPlayConfigDetails (2, 2, sampleRate, blockSize);
+            processor->setRandomSeed (2022 + i);
+
+            for (auto& parameterValue : schedule.parameterValues)
+                Schedules::setParameter (*processor, parameterValue.first, parameterValue.second);
+
+            if (! processor->loadImpulseResponse (impulseResponse))
+                std::cerr << "Could not load the impulse response, Extra Virgin will be silent" << std::endl;
+
+            processor->prepareToPlay (sampleRate, blockSize);
+            processor->getQualityGovernor().setEnabled (useGovernor);
+            processors.push_back (std::move (processor));
+        }
+    });
+
+    // The convolvers are built in the background, and must be there before the timing starts:
+    if (impulseResponse != juce::File())
+        for (auto& processor : processors)
+            processor->waitForImpulseResponse (-1);
+
+    juce::AudioBuffer<float> input (2, (int) (seconds * sampleRate));
+    fillInput (input, sampleRate);
+
+    juce::AudioBuffer<float> block (2, blockSize);
+    juce::MidiBuffer midiMessages;
+    juce::Random random (7);
+
+    auto numCallbacks = input.getNumSamples() / blockSize;
+    auto numWarmUpCallbacks = std::min ((int) (warmUpSeconds * sampleRate / blockSize), numCallbacks - 1);
+    auto deadline = blockSize / sampleRate;
+
+    std::vector<double> loads;
+    loads.reserve ((size_t) numCallbacks);
+
+    if (traceFile != juce::File() && ! processors.front()->getTraceRecorder().start (traceFile))
+        std::cerr << "Could not create " << traceFile.getFullPathName() << std::endl;
+
+    for (int callback = 0; callback < numCallbacks; callback++)
+    {
+        // The automation and the copies of the input are the host's work, and stay out of the timing:
+        if (schedule.automate != nullptr)
+            for (auto& processor : processors)
+                schedule.automate (*processor, callback * deadline, random);
+
+        auto startTicks = juce::Time::getHighResolutionTicks();
+
+        for (auto& processor : processors)
+        {
+            block.copyFrom (0, 0, input, 0, callback * blockSize, blockSize);
+            block.copyFrom (1, 0, input, 1, callback * blockSize, blockSize);
+            processor->processBlock (block, midiMessages);
+        }
+
+        auto elapsed = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+
+        if (callback >= numWarmUpCallbacks)
+            loads.push_back (elapsed / deadline);
+    }
+
+    HostThreads::callOnMessageThread ([&]
+    {
+        for (auto& processor : processors)
+        {
+            processor->getTraceRecorder().stop();
+            processor->releaseResources();
+        }
+
+        processors.clear();
+    });
+
+    Loads result;
+
+    for (auto load : loads)
+    {
+        result.mean += load / (double) loads.size();
+        result.missedDeadlines += load > 1.0 ? 1 : 0;
+    }
+
+    std::sort (loads.begin(), loads.end());
+    result.percentile999 = loads[(size_t) std::ceil (0.999 * (double) loads.size()) - 1];
+    result.max = loads.back();
+
+    return result;
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList arguments (argc, argv);
+
+    if (arguments.containsOption ("--help|-h"))
+    {
+        std::cout << usage;
+        return 0;
+    }
+
+    auto numInstances = arguments.containsOption ("--instances") ? std::max (1, arguments.getValueForOption ("--instances").getIntValue()) : 1;
+    auto seconds = arguments.containsOption ("--seconds") ? arguments.getValueForOption ("--seconds").getDoubleValue() : 10.0;
+    auto maxLoad = arguments.containsOption ("--max-load") ? arguments.getValueForOption ("--max-load").getDoubleValue() : 0.7;
+    auto filter = arguments.getValueForOption ("--filter");
+    auto useGovernor = arguments.containsOption ("--governor");
+    auto blockSizes = parseList (arguments, "--block-size", 64.0);
+    auto sampleRates = parseList (arguments, "--sample-rate", 48000.0);
+    auto traceDirectory = arguments.containsOption ("--trace-dir") ? arguments.getFileForOption ("--trace-dir") : juce::File();
+
+    if (traceDirectory != juce::File() && ! traceDirectory.createDirectory())
+    {
+        std::cerr << "Could not create " << traceDirectory.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    seconds = std::max (seconds, 2.0 * warmUpSeconds);
+    std::atomic<int> failures { 0 };
+
+    // Resampled to the rate of each run when loaded:
+    SyntheticImpulseResponse impulseResponse (48000.0);
+
+    // The schedules play on their own thread, standing in for the host's audio thread, while this one runs the
+    // message loop: the processors' timers start the freeze analyses and collect the old convolvers, as in a host.
+    HostThreads::run ([&]
+    {
+        for (auto& schedule : Schedules::makeSchedules())
+        {
+            if (filter.isNotEmpty() && ! schedule.name.containsIgnoreCase (filter))
+                continue;
+
+            std::cout << schedule.name << ": " << schedule.description << std::endl;
+
+            for (auto sampleRate : sampleRates)
+            {
+                for (auto blockSize : blockSizes)
+                {
+                    auto traceFile = traceDirectory != juce::File()
+                                         ? traceDirectory.getChildFile (schedule.name + "_" + juce::String ((int) blockSize) + "_" + juce::String ((int) sampleRate) + ".json")
+                                         : juce::File();
+
+                    auto loads = runSchedule (schedule, numInstances, sampleRate, (int) blockSize, seconds, useGovernor, impulseResponse.getFile(), traceFile);
+                    auto passed = loads.percentile999 <= maxLoad && loads.missedDeadlines == 0;
+                    failures += passed ? 0 : 1;
+
+                    std::cout << "  " << numInstances << (numInstances == 1 ? " instance, " : " instances, ")
+                              << (int) blockSize << " samples at " << sampleRate << " Hz: "
+                              << "p99.9 " << juce::String (100.0 * loads.percentile999, 1) << "%, "
+                              << "max " << juce::String (100.0 * loads.max, 1) << "%, "
+                              << "mean " << juce::String (100.0 * loads.mean, 1) << "% of the "
+                              << juce::String (1000.0 * blockSize / sampleRate, 2) << " ms deadline, "
+                              << loads.missedDeadlines << " missed, "
+                              << (passed ? "ok" : "FAILED") << std::endl;
+                }
+            }
+        }
+    });
+
+    std::cout << (failures == 0 ? juce::String ("Every schedule kept its deadlines") : juce::String (failures.load()) + " runs too close to their deadlines") << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+    Schedules.h
+    Created: 18 Oct 2026 4:41:18am
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+
+/**
+ The adversarial parameter schedules the stress suite plays: settings that make every grain and synth do its most
+ expensive work, and changes that make them do it in the same callback. Each schedule starts from the default
+ parameters, sets its own values on top, then moves parameters between callbacks as the host's automation would.
+ */
+namespace Schedules
+{
+    /// One schedule: fixed settings, and the automation played over them.
+    struct Schedule
+    {
+        juce::String name;
+        juce::String description;
+        std::vector<std::pair<juce::String, float>> parameterValues;    // In their own units
+        std::function<void (juce::AudioProcessor&, double, juce::Random&)> automate;   // Before every callback, given the time in seconds
+    };
+
+    /// Sets a parameter of the processor from its real (not normalised) value, unless it already has that value.
+    inline void setParameter (juce::AudioProcessor& processor, const juce::String& parameterID, float value)
+    {
+        for (auto* parameter : processor.getParameters())
+        {
+            if (auto* rangedParameter = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+            {
+                auto normalisedValue = rangedParameter->convertTo0to1 (value);
+
+                if (rangedParameter->paramID == parameterID && rangedParameter->getValue() != normalisedValue)
+                    rangedParameter->setValueNotifyingHost (normalisedValue);
+            }
+        }
+    }
+
+    /// The shortest grains, all five of them, none skipped, and synths listening to the quietest grains.
+    inline std::vector<std::pair<juce::String, float>> shortestChop()
+    {
+        return { { "grain_Length", 0.02f }, { "active_Grains", 4.99f }, { "chanceToSkip_Grain", 0.0f },
+                 { "synth_Volume_Threshold", 0.01f }, { "frequency_Precision", 1.0f } };
+    }
+
+    /// Appends settings to a list of them.
+    inline std::vector<std::pair<juce::String, float>> with (std::vector<std::pair<juce::String, float>> parameterValues,
+                                                            std::initializer_list<std::pair<juce::String, float>> moreValues)
+    {
+        parameterValues.insert (parameterValues.end(), moreValues.begin(), moreValues.end());
+        return parameterValues;
+    }
+
+    //==========================================================================
+    /// Lists every schedule.
+    inline std::vector<Schedule> makeSchedules()
+    {
+        std::vector<Schedule> schedules;
+
+        schedules.push_back ({ "default", "the default parameters, for reference", {}, nullptr });
+
+        schedules.push_back ({ "shortest-chop", "20 ms grains, five of them, each starting a synth and its pitch analysis",
+                               shortestChop(), nullptr });
+
+        // Every change of Onion sets the phases of all the grains at once: at 1 they land on two phases, so that
+        // the grains, and the pitch analyses of their synths, start together in the same callback.
+        schedules.push_back ({ "aligned-grains", "Onion jumping between 1 and 4.99 every 50 ms, restarting every grain together",
+                               shortestChop(),
+                               [] (juce::AudioProcessor& processor, double time, juce::Random&)
+                               {
+                                   setParameter (processor, "active_Grains", std::fmod (time, 0.1) < 0.05 ? 1.0f : 4.99f);
+                               } });
+
+        schedules.push_back ({ "spectral", "Blender on the shortest grains, stretched and stirred",
+                               with (shortestChop(), { { "grain_Spectral", 1.0f }, { "spectral_Stretch", 0.5f }, { "spectral_Smear", 1.0f } }),
+                               nullptr });
+
+        schedules.push_back ({ "everything-on", "the shortest grains with Salt, Cucumber, Pepper and the convolution reverb on a 3 second response",
+                               with (shortestChop(), { { "onset_Snap", 1.0f }, { "grain_Filter", 1.0f }, { "grain_FilterRandomness", 1.0f },
+                                                       { "grain_FilterResonance", 10.0f }, { "reverb_Amount", 0.99f }, { "reverb_Convolution", 1.0f } }),
+                               nullptr });
+
+        schedules.push_back ({ "leftovers", "Leftovers toggled every 250 ms, swapping the frozen analysis in and out",
+                               shortestChop(),
+                               [] (juce::AudioProcessor& processor, double time, juce::Random&)
+                               {
+                                   setParameter (processor, "freeze", std::fmod (time, 0.5) < 0.25 ? 0.0f : 1.0f);
+                               } });
+
+        schedules.push_back ({ "automation", "three parameters jumping to random values before every callback",
+                               shortestChop(),
+                               [] (juce::AudioProcessor& processor, double, juce::Random& random)
+                               {
+                                   auto& parameters = processor.getParameters();
+
+                                   for (int i=0; i<3; i++)
+                                   {
+                                       auto* parameter = dynamic_cast<juce::RangedAudioParameter*> (parameters[random.nextInt (parameters.size())]);
+
+                                       // Chef's Shortcuts only reports the level of the QualityGovernor:
+                                       if (parameter != nullptr && parameter->paramID != "quality_Level")
+                                           parameter->setValueNotifyingHost (random.nextFloat());
+                                   }
+                               } });
+
+        return schedules;
+    }
+}
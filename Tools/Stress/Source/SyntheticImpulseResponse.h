@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    SyntheticImpulseResponse.h
+    Created: 18 Oct 2026 6:12:40pm
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ A made up impulse response for the convolution reverb, written to a temporary WAV file that goes away with the object:
+ stereo noise decaying by 60 dB over its length, as a large hall's would. A few seconds of it keep every partition of
+ the convolution busy, which a missing or short response wouldn't. Shared by TabboulehStress and TabboulehRealtimeCheck.
+ */
+class SyntheticImpulseResponse
+{
+public:
+    /**
+     Writes the response.
+
+     @param sampleRate sample rate of the file
+     @param lengthInSeconds length of the response
+     */
+    SyntheticImpulseResponse (double sampleRate, double lengthInSeconds = 3.0)
+    {
+        juce::AudioBuffer<float> buffer (2, (int) (lengthInSeconds * sampleRate));
+        juce::Random random (60);
+
+        for (int i=0; i<buffer.getNumSamples(); i++)
+        {
+            auto gain = 0.5f * (float) std::pow (10.0, -3.0 * i / buffer.getNumSamples());
+
+            buffer.setSample (0, i, gain * (random.nextFloat() * 2.0f - 1.0f));
+            buffer.setSample (1, i, gain * (random.nextFloat() * 2.0f - 1.0f));
+        }
+
+        auto stream = file.getFile().createOutputStream();
+
+        if (stream == nullptr)
+            return;
+
+        juce::WavAudioFormat format;
+        std::unique_ptr<juce::AudioFormatWriter> writer (format.createWriterFor (stream.get(), sampleRate, 2, 24, {}, 0));
+
+        if (writer == nullptr)
+            return;
+
+        stream.release();
+        written = writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+    }
+
+    /// The file, once written. Returns an empty File if it couldn't be.
+    juce::File getFile() const
+    {
+        return written ? file.getFile() : juce::File();
+    }
+
+private:
+    juce::TemporaryFile file { ".wav" };
+    bool written = false;
+};